@@ -0,0 +1,100 @@
+#include "audio.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace CHIP8 {
+
+namespace {
+
+const uint32_t FRAMES_PER_SECOND = 60;
+const uint64_t PATTERN_BITS = 128;
+
+}  // namespace
+
+AudioStream::AudioStream(const AudioConfig& config)
+    : settings(config),
+      latency_samples(size_t(config.sample_rate) * config.max_latency_ms /
+                      1000) {
+}
+
+void AudioStream::submitFrame(bool on, const uint8_t (&pattern)[16],
+                              uint8_t pitch) {
+    frame_remainder += settings.sample_rate;
+    size_t count = frame_remainder / FRAMES_PER_SECOND;
+    frame_remainder %= FRAMES_PER_SECOND;
+    generated += count;
+
+    // Whatever is still queued, plus the device buffer, plays before this
+    // frame does; drop the frame's head rather than fall further behind.
+    size_t lag = ring.size() + settings.device_samples;
+    size_t skip = lag > latency_samples
+                      ? std::min(lag - latency_samples, count)
+                      : 0;
+    uint64_t step = 0;
+    if (on) {
+        double bits_per_second = 4000.0 * std::exp2((pitch - 64) / 48.0);
+        step = uint64_t(bits_per_second / settings.sample_rate *
+                        4294967296.0);
+    }
+    // Dropped samples only move the oscillator on, so a turbo run that
+    // drops nearly whole frames synthesizes next to nothing.
+    const uint64_t phase_mask = (PATTERN_BITS << 32) - 1;
+    phase = (phase + skip * step) & phase_mask;
+    dropped += skip;
+    for (size_t i = skip; i < count; ++i) {
+        int16_t sample = 0;
+        if (on) {
+            uint32_t bit = uint32_t(phase >> 32);
+            sample = (pattern[bit >> 3] >> (7 - (bit & 7))) & 1 ? AMPLITUDE
+                                                                : -AMPLITUDE;
+            phase = (phase + step) & phase_mask;
+        }
+        if (!ring.push(sample)) {
+            ++dropped;
+        }
+    }
+}
+
+size_t AudioStream::mix(int16_t* out, size_t count) {
+    size_t played = ring.pop(out, count);
+    std::fill(out + played, out + count, int16_t(0));
+    return played;
+}
+
+Chip8Audio::Chip8Audio(const AudioConfig& config) : audio(config) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+        return;
+    }
+    SDL_AudioSpec wanted = {};
+    wanted.freq = config.sample_rate;
+    wanted.format = AUDIO_S16SYS;
+    wanted.channels = 1;
+    wanted.samples = Uint16(config.device_samples);
+    wanted.callback = callback;
+    wanted.userdata = &audio;
+    // No allowed changes: SDL converts to whatever the hardware wants, so
+    // the stream's rate and buffer size hold.
+    device = SDL_OpenAudioDevice(nullptr, 0, &wanted, nullptr, 0);
+    if (device == 0) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return;
+    }
+    SDL_PauseAudioDevice(device, 0);
+}
+
+Chip8Audio::~Chip8Audio() {
+    if (device != 0) {
+        SDL_CloseAudioDevice(device);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+}
+
+void Chip8Audio::callback(void* userdata, uint8_t* bytes, int length) {
+    static_cast<AudioStream*>(userdata)->mix(
+        reinterpret_cast<int16_t*>(bytes), size_t(length) / sizeof(int16_t));
+}
+
+}  // namespace CHIP8
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "spsc_ring.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief Host audio settings. The defaults give about 11 ms from a frame
+ * to its first sample reaching the device.
+ */
+struct AudioConfig {
+    int sample_rate = 48000;
+    // Samples per SDL callback, 5.3 ms at 48 kHz
+    int device_samples = 256;
+    // Bound on how late the start of a frame may play; frames that would
+    // start later are shortened instead of queued.
+    int max_latency_ms = 20;
+};
+
+/**
+ * @brief Turns the sound timer, the XO-CHIP pattern and pitch into 16-bit
+ * mono samples, queued in a lock-free ring between the emulation thread
+ * (submitFrame()) and the audio thread (mix()).
+ *
+ * Classic programs play the power-on pattern, a 500 Hz square wave, so
+ * the buzzer needs no case of its own. Neither side ever blocks: samples
+ * that do not fit the latency budget are dropped and an empty ring plays
+ * silence.
+ */
+class AudioStream {
+public:
+    // 170 ms at 48 kHz, far more than any sane latency budget
+    static const size_t RING_SAMPLES = 1 << 13;
+    static const int16_t AMPLITUDE = 0x1800;
+
+    explicit AudioStream(const AudioConfig& config);
+
+    /**
+     * @brief Producer side. Queues one 60 Hz frame of audio: the pattern
+     * played at 4000 * 2^((pitch - 64) / 48) bits per second while `on`,
+     * silence otherwise.
+     */
+    void submitFrame(bool on, const uint8_t (&pattern)[16], uint8_t pitch);
+
+    /**
+     * @brief Consumer side. Fills `out` with `count` samples, padding
+     * with silence when the ring runs dry.
+     *
+     * @return The number of queued samples that were played.
+     */
+    size_t mix(int16_t* out, size_t count);
+
+    const AudioConfig& config() const {
+        return settings;
+    }
+    // Producer-side totals of generated samples and of those dropped.
+    uint64_t samplesGenerated() const {
+        return generated;
+    }
+    uint64_t samplesDropped() const {
+        return dropped;
+    }
+    size_t queued() const {
+        return ring.size();
+    }
+
+private:
+    AudioConfig settings;
+    size_t latency_samples;        // max_latency_ms in samples
+    uint32_t frame_remainder = 0;  // Spreads sample_rate / 60 over frames
+    uint64_t phase = 0;            // Pattern position, 32.32 fixed point
+    uint64_t generated = 0;
+    uint64_t dropped = 0;
+    SpscRing<int16_t, RING_SAMPLES> ring;
+};
+
+/**
+ * @brief SDL audio device playing an AudioStream from its callback. Works
+ * with any SDL audio driver, including `dummy` and `disk` for headless
+ * runs (SDL_AUDIODRIVER).
+ */
+class Chip8Audio {
+public:
+    explicit Chip8Audio(const AudioConfig& config);
+    ~Chip8Audio();
+
+    Chip8Audio(const Chip8Audio&) = delete;
+    Chip8Audio& operator=(const Chip8Audio&) = delete;
+
+    // False if SDL could not open a device.
+    bool isOpen() const {
+        return device != 0;
+    }
+
+    AudioStream& stream() {
+        return audio;
+    }
+    const AudioStream& stream() const {
+        return audio;
+    }
+
+private:
+    static void callback(void* userdata, uint8_t* bytes, int length);
+
+    AudioStream audio;
+    uint32_t device = 0;  // SDL_AudioDeviceID
+};
+
+}  // namespace CHIP8
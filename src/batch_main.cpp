@@ -0,0 +1,285 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "chip8.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+struct BatchOptions {
+    std::vector<std::string> roms;
+    uint64_t instances = 1;
+    uint64_t frames = 600;  // Ten emulated seconds
+    uint64_t cycles = 0;    // Exact instruction budget, overrides frames
+    uint32_t cycles_per_frame = CHIP8::Chip8CPU::DEFAULT_CYCLES_PER_FRAME;
+    CHIP8::Chip8Engine engine = CHIP8::Chip8Engine::THREADED;
+    CHIP8::MemoryPolicy memory_policy = CHIP8::MemoryPolicy::CHECKED;
+    bool has_quirks = false;  // Else looked up in quirks_db
+    CHIP8::QuirkProfile quirks = CHIP8::QuirkProfile::DEFAULT;
+    CHIP8::QuirkDatabase quirks_db;
+    size_t threads = 0;
+    uint64_t seed = 1;
+    std::string out_path;
+    std::string dump_dir;
+};
+
+struct InstanceResult {
+    std::string rom;
+    std::shared_ptr<const CHIP8::RomImage> image;  // nullptr if unreadable
+    CHIP8::QuirkProfile quirks = CHIP8::QuirkProfile::DEFAULT;
+    uint64_t instance = 0;
+    uint64_t cycles = 0;
+    uint64_t frames = 0;
+    uint64_t hash = 0;
+    std::string error;
+};
+
+void printUsage(const char* program) {
+    std::cerr
+        << "Usage: " << program << " [options] <ROM file>...\n"
+        << "  --list <file>     Also run the ROMs listed in file, one per line\n"
+        << "  --instances <n>   Run n instances of every ROM (default 1)\n"
+        << "  --frames <n>      Frames to run per instance (default 600)\n"
+        << "  --cycles <n>      Run exactly n instructions per instance\n"
+        << "  --ipf <n>         Instructions per frame (default "
+        << CHIP8::Chip8CPU::DEFAULT_CYCLES_PER_FRAME << ")\n"
+        << "  --engine <name>   interpreter, threaded (default) or jit\n"
+        << "  --memory <name>   Out-of-range accesses: checked (default), "
+           "masked or trap\n"
+        << "  --quirks <name>   default, vip, schip or xochip for every ROM\n"
+        << "  --quirks-db <db>  Pick the quirk profile of each ROM from db\n"
+        << "  --seed <n>        CXNN seed, instance i uses n + i (default 1)\n"
+        << "  --threads <n>     Worker threads (default: all hardware threads)\n"
+        << "  --out <file>      Write results to file instead of stdout\n"
+        << "  --dump-dir <dir>  Write final framebuffers as <dir>/<index>.pbm"
+        << std::endl;
+}
+
+bool readRomList(const std::string& path, std::vector<std::string>& roms) {
+    std::ifstream list(path);
+    if (!list.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line[0] != '#') {
+            roms.push_back(line);
+        }
+    }
+    return true;
+}
+
+bool parseArgs(int argc, char* argv[], BatchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        try {
+            if (arg == "--list" && has_value) {
+                if (!readRomList(argv[++i], options.roms)) {
+                    std::cerr << "Cannot read ROM list: " << argv[i]
+                              << std::endl;
+                    return false;
+                }
+            } else if (arg == "--instances" && has_value) {
+                options.instances = std::stoull(argv[++i]);
+            } else if (arg == "--frames" && has_value) {
+                options.frames = std::stoull(argv[++i]);
+            } else if (arg == "--cycles" && has_value) {
+                options.cycles = std::stoull(argv[++i]);
+            } else if (arg == "--ipf" && has_value) {
+                options.cycles_per_frame = std::stoul(argv[++i]);
+            } else if (arg == "--engine" && has_value) {
+                if (!CHIP8::parseEngineName(argv[++i], options.engine)) {
+                    return false;
+                }
+            } else if (arg == "--memory" && has_value) {
+                if (!CHIP8::parseMemoryPolicyName(argv[++i],
+                                                  options.memory_policy)) {
+                    return false;
+                }
+            } else if (arg == "--quirks" && has_value) {
+                if (!CHIP8::parseQuirkProfileName(argv[++i], options.quirks)) {
+                    return false;
+                }
+                options.has_quirks = true;
+            } else if (arg == "--quirks-db" && has_value) {
+                if (!options.quirks_db.load(argv[++i])) {
+                    std::cerr << "Cannot read quirk database: " << argv[i]
+                              << std::endl;
+                    return false;
+                }
+            } else if (arg == "--seed" && has_value) {
+                options.seed = std::stoull(argv[++i], nullptr, 0);
+            } else if (arg == "--threads" && has_value) {
+                options.threads = std::stoul(argv[++i]);
+            } else if (arg == "--out" && has_value) {
+                options.out_path = argv[++i];
+            } else if (arg == "--dump-dir" && has_value) {
+                options.dump_dir = argv[++i];
+            } else if (!arg.empty() && arg[0] != '-') {
+                options.roms.push_back(arg);
+            } else {
+                return false;
+            }
+        } catch (...) {
+            std::cerr << "Invalid value for " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.roms.empty() && options.cycles_per_frame > 0;
+}
+
+// Plain PBM (P1), readable by most image tools.
+void dumpFramebuffer(const CHIP8::Framebuffer& display,
+                     const std::string& path) {
+    std::ofstream out(path);
+    out << "P1\n"
+        << display.width() << " " << display.height() << "\n";
+    for (int y = 0; y < display.height(); ++y) {
+        for (int x = 0; x < display.width(); ++x) {
+            out << (display.getPixel(x, y) ? '1' : '0');
+        }
+        out << "\n";
+    }
+}
+
+void runInstance(const BatchOptions& options, size_t index,
+                 InstanceResult& result) {
+    try {
+        if (!result.image) {
+            result.error = "Failed to load ROM: " + result.rom;
+            return;
+        }
+        CHIP8::Chip8CPU cpu(CHIP8::Chip8Mode::HEADLESS, *result.image);
+        cpu.seedRandom(options.seed + index);
+        cpu.setMemoryPolicy(options.memory_policy);
+        cpu.setQuirkProfile(result.quirks);
+        if (!cpu.setEngine(options.engine)) {
+            result.error = "engine not available";
+            return;
+        }
+        if (options.cycles > 0) {
+            result.frames = options.cycles / options.cycles_per_frame;
+            result.cycles =
+                cpu.runFrames(result.frames, options.cycles_per_frame);
+            result.cycles +=
+                cpu.execute(options.cycles % options.cycles_per_frame);
+        } else {
+            result.frames = options.frames;
+            result.cycles =
+                cpu.runFrames(options.frames, options.cycles_per_frame);
+        }
+        result.hash = cpu.stateHash();
+        if (const CHIP8::MemoryFault* fault = cpu.getMemoryFault()) {
+            std::ostringstream message;
+            message << "memory fault at PC 0x" << std::hex << fault->pc
+                    << ", address 0x" << fault->address;
+            result.error = message.str();
+        }
+        if (!options.dump_dir.empty() && cpu.getDisplay()) {
+            dumpFramebuffer(*cpu.getDisplay(), options.dump_dir + "/" +
+                                                   std::to_string(index) +
+                                                   ".pbm");
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+}
+
+std::string csvQuote(const std::string& field) {
+    std::string quoted = "\"";
+    for (char c : field) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void writeResults(std::ostream& out,
+                  const std::vector<InstanceResult>& results) {
+    out << "index,rom,instance,cycles,frames,hash,error\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const InstanceResult& r = results[i];
+        out << i << "," << csvQuote(r.rom) << "," << r.instance << ","
+            << r.cycles << "," << r.frames << "," << std::hex
+            << std::setw(16) << std::setfill('0') << r.hash << std::dec
+            << std::setfill(' ') << "," << csvQuote(r.error) << "\n";
+    }
+}
+
+}  // namespace
+
+// Runs many headless CHIP-8 instances in one process, spread over a
+// work-stealing thread pool, and reports the final state of each.
+int main(int argc, char* argv[]) {
+    BatchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<InstanceResult> results;
+    // Every instance of a ROM boots from one shared image.
+    for (const std::string& rom : options.roms) {
+        auto image = CHIP8::RomCache::global().load(rom);
+        CHIP8::QuirkProfile quirks = options.quirks;
+        if (image && !options.has_quirks) {
+            options.quirks_db.lookup(image->hash, quirks);
+        }
+        for (uint64_t instance = 0; instance < options.instances; ++instance) {
+            InstanceResult result;
+            result.rom = rom;
+            result.image = image;
+            result.quirks = quirks;
+            result.instance = instance;
+            results.push_back(result);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t threads;
+    {
+        CHIP8::ThreadPool pool(options.threads);
+        threads = pool.size();
+        for (size_t i = 0; i < results.size(); ++i) {
+            pool.submit([&options, &results, i] {
+                runInstance(options, i, results[i]);
+            });
+        }
+        pool.wait();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (options.out_path.empty()) {
+        writeResults(std::cout, results);
+    } else {
+        std::ofstream out(options.out_path);
+        if (!out.is_open()) {
+            std::cerr << "Cannot write results to " << options.out_path
+                      << std::endl;
+            return 1;
+        }
+        writeResults(out, results);
+    }
+
+    uint64_t total_cycles = 0;
+    size_t failed = 0;
+    for (const InstanceResult& r : results) {
+        total_cycles += r.cycles;
+        failed += !r.error.empty();
+    }
+    std::cerr << results.size() << " instances (" << failed << " failed) on "
+              << threads << " threads in " << elapsed.count() << " s, "
+              << total_cycles / elapsed.count() / 1e6 << " MIPS" << std::endl;
+    return failed == 0 ? 0 : 2;
+}
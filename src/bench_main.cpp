@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "chip8.hpp"
+
+// Runs the same ROM headless on every engine and reports instructions per
+// second, so the engines can be compared on the host that will run them.
+// With --movie every engine replays the same recorded gameplay instead, and
+// the final state hashes show whether they agree.
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string movie_path;
+    uint64_t instructions = 10000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--movie" && i + 1 < argc) {
+            movie_path = argv[++i];
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            try {
+                instructions = std::stoull(arg);
+            } catch (...) {
+                std::cerr << "Invalid instruction count: " << arg
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <ROM file> [instructions] [--movie <file>]"
+                  << std::endl;
+        return 1;
+    }
+
+    const CHIP8::Chip8Engine engines[] = {CHIP8::Chip8Engine::INTERPRETER,
+                                          CHIP8::Chip8Engine::THREADED,
+                                          CHIP8::Chip8Engine::JIT};
+    try {
+        for (CHIP8::Chip8Engine engine : engines) {
+            CHIP8::Chip8CPU cpu(movie_path.empty() ? CHIP8::Chip8Mode::TEST
+                                                   : CHIP8::Chip8Mode::HEADLESS,
+                                path);
+            if (!cpu.setEngine(engine)) {
+                std::cerr << std::setw(12) << CHIP8::engineName(engine)
+                          << ": not available" << std::endl;
+                continue;
+            }
+            if (!movie_path.empty() && !cpu.startReplay(movie_path)) {
+                std::cerr << "Cannot replay movie " << movie_path << std::endl;
+                return 1;
+            }
+            auto start = std::chrono::steady_clock::now();
+            uint64_t executed = 0;
+            if (movie_path.empty()) {
+                executed = cpu.execute(instructions);
+            } else {
+                while (cpu.isReplaying()) {
+                    executed += cpu.runFrames(1, cpu.getCyclesPerFrame());
+                }
+            }
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            std::cout << std::setw(12) << CHIP8::engineName(engine) << ": "
+                      << std::fixed << std::setprecision(2)
+                      << executed / elapsed.count() / 1e6 << " MIPS ("
+                      << executed << " instructions in " << std::setprecision(3)
+                      << elapsed.count() << " s)";
+            if (!movie_path.empty()) {
+                std::cout << ", state " << std::hex << std::setw(16)
+                          << std::setfill('0') << cpu.stateHash() << std::dec
+                          << std::setfill(' ');
+            }
+            std::cout << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
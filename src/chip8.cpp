@@ -1,55 +1,115 @@
 #include "chip8.hpp"
 
-#include <iomanip>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
 #include <random>
+#include <stdexcept>
 #include <thread>
 
 #include "display.hpp"
 #include "input.hpp"
-#include "memory.hpp"
-#include "register.hpp"
-#include "stack.hpp"
-
-// Fontset for CHIP-8
-static const uint8_t fontset[80] = {
-    0xF0, 0x90, 0x90, 0x90, 0xF0,  // 0
-    0x20, 0x60, 0x20, 0x20, 0x70,  // 1
-    0xF0, 0x10, 0xF0, 0x80, 0xF0,  // 2
-    0xF0, 0x10, 0xF0, 0x10, 0xF0,  // 3
-    0x90, 0x90, 0xF0, 0x10, 0x10,  // 4
-    0xF0, 0x80, 0xF0, 0x10, 0xF0,  // 5
-    0xF0, 0x80, 0xF0, 0x90, 0xF0,  // 6
-    0xF0, 0x10, 0x20, 0x40, 0x40,  // 7
-    0xF0, 0x90, 0xF0, 0x90, 0xF0,  // 8
-    0xF0, 0x90, 0xF0, 0x10, 0xF0,  // 9
-    0xF0, 0x90, 0xF0, 0x90, 0x90,  // A
-    0xE0, 0x90, 0xE0, 0x90, 0xE0,  // B
-    0xF0, 0x80, 0x80, 0x80, 0xF0,  // C
-    0xE0, 0x90, 0x90, 0x90, 0xE0,  // D
-    0xF0, 0x80, 0xF0, 0x80, 0xF0,  // E
-    0xF0, 0x80, 0xF0, 0x80, 0x80   // F
-};
+#include "machine_state.hpp"
+#include "triple_buffer.hpp"
 
 namespace CHIP8 {
 
+/**
+ * @brief Compile-time configuration of one instantiation of the CPU core:
+ * a memory access policy plus the quirks of a profile.
+ */
+template <class Access, QuirkProfile Profile>
+struct CoreConfig : Access {
+    static constexpr QuirkProfile PROFILE = Profile;
+    static constexpr Quirks QUIRKS = quirksOf(Profile);
+    static constexpr uint32_t MEMORY_SIZE = QUIRKS.memory_size;
+};
+
+template <class Access, class Visitor>
+static auto withProfile(QuirkProfile profile, Visitor&& visit) {
+    switch (profile) {
+        case QuirkProfile::VIP:
+            return visit(CoreConfig<Access, QuirkProfile::VIP>());
+        case QuirkProfile::SCHIP:
+            return visit(CoreConfig<Access, QuirkProfile::SCHIP>());
+        case QuirkProfile::XOCHIP:
+            return visit(CoreConfig<Access, QuirkProfile::XOCHIP>());
+        case QuirkProfile::DEFAULT:
+            break;
+    }
+    return visit(CoreConfig<Access, QuirkProfile::DEFAULT>());
+}
+
+// Calls `visit` with the CoreConfig matching the runtime settings, so one
+// switch here selects a core with no further checks inside it.
+template <class Visitor>
+static auto withCore(MemoryPolicy policy, QuirkProfile profile,
+                     Visitor&& visit) {
+    switch (policy) {
+        case MemoryPolicy::CHECKED:
+            return withProfile<CheckedAccess>(profile, visit);
+        case MemoryPolicy::TRAPPING:
+            return withProfile<TrappingAccess>(profile, visit);
+        case MemoryPolicy::MASKED:
+            break;
+    }
+    return withProfile<MaskedAccess>(profile, visit);
+}
+
 Chip8CPU::Chip8CPU() : Chip8CPU(Chip8Mode::NORMAL) {
 }
 
-Chip8CPU::Chip8CPU(Chip8Mode mode) {
-    mem = std::make_unique<Memory>();
-    reg = std::make_unique<Register>();
+Chip8CPU::Chip8CPU(Chip8Mode mode) : mode(mode) {
+    state.reset();
+    decode_cache = std::make_shared<DecodeCache>();
 
-    stack = std::make_unique<Stack>(reg->SP, stack_array);
+    std::random_device seed_source;
+    seedRandom((uint64_t(seed_source()) << 32) | seed_source());
 
     if (mode == Chip8Mode::NORMAL) {
         display = std::make_unique<Chip8Display>();
         keypad = std::make_unique<Chip8Keypad>();
-    } else {
-        display = nullptr;
-        keypad = nullptr;
+        setAudio(AudioConfig());
     }
-    mem->loadFontset(fontset, sizeof(fontset));
+    // Nothing is decoded or observed yet, so the writes need no notifying.
+    state.memory = RomCache::blank().boot;
+}
+
+Chip8CPU::Chip8CPU(const Chip8CPU& parent, ForkTag)
+    : memory_extent(parent.memory_extent),
+      mode(parent.mode == Chip8Mode::NORMAL ? Chip8Mode::HEADLESS
+                                            : parent.mode),
+      decode_cache(parent.decode_cache),
+      engine(parent.engine == Chip8Engine::JIT ? Chip8Engine::THREADED
+                                               : parent.engine),
+      memory_policy(parent.memory_policy),
+      quirk_profile(parent.quirk_profile),
+      cycles_per_frame(parent.cycles_per_frame),
+      instructions(parent.instructions) {
+    std::memcpy(&state, &parent.state, parent.state_bytes());
+    decode_cache->frozen.store(true, std::memory_order_release);
+}
+
+Chip8CPU Chip8CPU::fork() const {
+    return Chip8CPU(*this, ForkTag());
+}
+
+void Chip8CPU::setKeys(uint16_t keys) {
+    state.keys = keys;
+}
+
+uint16_t Chip8CPU::getKeys() const {
+    return state.keys;
+}
+
+Chip8CPU::Chip8CPU(Chip8Mode mode, const RomImage& image)
+    : Chip8CPU(mode) {
+    state.memory = image.boot;
+    extend_memory(Memory::ROM_START_ADDR + image.size);
 }
 
 Chip8CPU::Chip8CPU(Chip8Mode mode, const std::string& rom_path)
@@ -59,241 +119,1703 @@ Chip8CPU::Chip8CPU(Chip8Mode mode, const std::string& rom_path)
     }
 }
 
+// What the two threads of run() share. Only parking an idle machine takes
+// the mutex; frames, keys and flags otherwise pass through atomics.
+struct Chip8CPU::HostLink {
+    TripleBuffer<Framebuffer> frames;
+    std::atomic<uint16_t> keys{0};
+    std::atomic<bool> rewind_held{false};
+    std::atomic<bool> idle{false};  // Emulation parked until keys change
+    std::atomic<bool> stop{false};  // Window closed
+    std::atomic<bool> done{false};  // Emulation stopped on a fault
+    std::mutex mutex;
+    std::condition_variable wake;
+};
+
+using clock = std::chrono::steady_clock;
+
+static const clock::duration frame_duration =
+    std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / Chip8CPU::FRAME_RATE));
+// A frame that starts later than this is not caught up on, so a stall
+// (window drag, debugger pause) does not turn into a burst of frames.
+static const clock::duration max_lag = frame_duration * 4;
+
+// An idle machine still runs a frame this often, which costs next to
+// nothing and keeps it from depending on every wakeup being delivered.
+static const std::chrono::milliseconds max_idle(250);
+
+static void sleepUntilNextFrame(clock::time_point& deadline,
+                                clock::time_point now) {
+    deadline += frame_duration;
+    if (now - deadline > max_lag) {
+        deadline = now;
+    }
+    std::this_thread::sleep_until(deadline);
+}
+
 void Chip8CPU::run() {
-    using clock = std::chrono::high_resolution_clock;
-    auto last_cycle_time = clock::now();
-    auto last_timer_time = clock::now();
-    const std::chrono::duration<double> cpu_cycle_duration(1.0 /
-                                                           500.0);   // 500 Hz
-    const std::chrono::duration<double> timer_duration(1.0 / 60.0);  // 60 Hz
-    while (handle_input()) {
-        auto current_time = clock::now();
-        if (current_time - last_cycle_time >= cpu_cycle_duration) {
-            cycle();
-            last_cycle_time = current_time;
+    stats = RunStats();
+    auto start = clock::now();
+    if (!keypad || !display) {
+        return;
+    }
+    auto link = std::make_unique<HostLink>();
+    uint16_t keys = state.keys;
+    link->keys = keys;
+    link->frames.back() = state.display;
+    link->frames.publish();
+    std::thread emulation(&Chip8CPU::emulate, this, std::ref(*link));
+
+    // This thread owns SDL: it polls input and presents the newest frame
+    // once per real frame, however long either takes.
+    auto deadline = start;
+    while (!link->done.load(std::memory_order_acquire)) {
+        auto t0 = clock::now();
+        if (!keypad->handleInput(keys)) {
+            break;
+        }
+        bool rewind_held = keypad->isRewindHeld();
+        if (keys != link->keys.load(std::memory_order_relaxed) ||
+            rewind_held != link->rewind_held.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(link->mutex);
+                link->keys.store(keys, std::memory_order_relaxed);
+                link->rewind_held.store(rewind_held,
+                                        std::memory_order_relaxed);
+            }
+            link->wake.notify_one();
+        }
+        auto t1 = clock::now();
+        // Read before taking the frame, so an idle machine's last frame is
+        // presented before waiting.
+        bool idle = link->idle.load(std::memory_order_acquire);
+        if (link->frames.update()) {
+            display->render(link->frames.front());
+        }
+        auto t2 = clock::now();
+        stats.input_seconds += std::chrono::duration<double>(t1 - t0).count();
+        stats.render_seconds +=
+            std::chrono::duration<double>(t2 - t1).count();
+        if (idle) {
+            keypad->waitForInput();
+            deadline = clock::now();
+        } else {
+            sleepUntilNextFrame(deadline, t2);
         }
-        if (current_time - last_timer_time >= timer_duration) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->stop.store(true, std::memory_order_relaxed);
+    }
+    link->wake.notify_one();
+    emulation.join();
+    stats.wall_seconds =
+        std::chrono::duration<double>(clock::now() - start).count();
+}
+
+void Chip8CPU::emulate(HostLink& link) {
+    auto deadline = clock::now();
+    while (!link.stop.load(std::memory_order_relaxed)) {
+        auto t0 = clock::now();
+        state.keys = link.keys.load(std::memory_order_relaxed);
+        // While the rewind key is held, frames run backward through the
+        // history at the normal frame rate instead of executing. Movies
+        // only run forward.
+        bool rewinding = rewind_buffer && !recorder && !player &&
+                         link.rewind_held.load(std::memory_order_relaxed);
+        if (!rewinding) {
+            movie_frame();
+            stats.instructions += execute(cycles_per_frame);
+        }
+        auto t1 = clock::now();
+        if (!rewinding) {
             update_timers();
-            last_timer_time = current_time;
+            ++stats.frames;
+        }
+        auto t2 = clock::now();
+        if (rewinding) {
+            rewind();
+        } else {
+            recordRewind();
+        }
+        auto t3 = clock::now();
+        link.frames.back() = state.display;
+        link.frames.publish();
+        stats.cpu_seconds += std::chrono::duration<double>(t1 - t0).count();
+        stats.timer_seconds += std::chrono::duration<double>(t2 - t1).count();
+        stats.rewind_seconds += std::chrono::duration<double>(t3 - t2).count();
+        if (faulted) {
+            break;
+        }
+
+        // A machine parked on FX0A with both timers stopped stays as it is
+        // until a key changes, so it sleeps until the keys do.
+        bool idle = !rewinding && !player && state.key_waiting &&
+                    state.reg.delay_timer == 0 && state.reg.sound_timer == 0;
+        auto t4 = clock::now();
+        if (idle) {
+            std::unique_lock<std::mutex> lock(link.mutex);
+            link.idle.store(true, std::memory_order_release);
+            link.wake.wait_for(lock, max_idle, [&] {
+                return link.stop.load(std::memory_order_relaxed) ||
+                       link.rewind_held.load(std::memory_order_relaxed) ||
+                       link.keys.load(std::memory_order_relaxed) != state.keys;
+            });
+            link.idle.store(false, std::memory_order_relaxed);
+            deadline = clock::now();
+        } else if (!turbo || rewinding) {
+            sleepUntilNextFrame(deadline, t4);
         }
-        render();
-        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        stats.sleep_seconds +=
+            std::chrono::duration<double>(clock::now() - t4).count();
     }
+    link.done.store(true, std::memory_order_release);
 }
 
-void Chip8CPU::cycle() {
-    std::cout << "PC: 0x" << std::hex << std::setw(4) << std::setfill('0')
-              << reg->PC << ", Opcode: 0x" << std::hex << std::setw(4)
-              << std::setfill('0')
-              << ((mem->readByte(reg->PC).value_or(0) << 8) |
-                  mem->readByte(reg->PC + 1).value_or(0))
-              << std::endl;
-
-    uint8_t high_byte = this->mem->readByte(this->reg->PC).value_or(0);
-    uint8_t low_byte = this->mem->readByte(this->reg->PC + 1).value_or(0);
-    uint16_t opcode = (high_byte << 8) | low_byte;
-
-    auto& V = reg->V;
-    auto& I = reg->I;
-    auto& PC = reg->PC;
-    auto& SP = reg->SP;
-
-    uint16_t nnn = opcode & 0x0FFF;
-    uint8_t nn = opcode & 0x00FF;
-    uint8_t n = opcode & 0x000F;
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void Chip8CPU::setTurbo(bool enabled) {
+    turbo = enabled;
+}
 
-    switch (opcode & 0xF000) {
-        case 0x0000:
-            switch (nn) {
-                case 0xE0:  // 00E0: CLS
-                    if (display) {
-                        display->clear();
-                    }
-                    break;
-                case 0xEE:                          // 00EE: RET
-                    PC = stack->pop().value_or(0);  // Safely unwrap optional
-                    break;
-            }
-            break;
-        case 0x1000:  // 1NNN: JP addr
-            PC = nnn;
-            return;   // Return to avoid PC += 2
-        case 0x2000:  // 2NNN: CALL addr
-            stack->push(PC);
-            PC = nnn;
-            return;   // Return to avoid PC += 2
-        case 0x3000:  // 3XNN: SE Vx, byte
-            if (V[x] == nn) PC += 2;
-            break;
-        case 0x4000:  // 4XNN: SNE Vx, byte
-            if (V[x] != nn) PC += 2;
-            break;
-        case 0x5000:  // 5XY0: SE Vx, Vy
-            if (V[x] == V[y]) PC += 2;
+bool Chip8CPU::getTurbo() const {
+    return turbo;
+}
+
+const RunStats& Chip8CPU::getRunStats() const {
+    return stats;
+}
+
+void Chip8CPU::setCyclesPerFrame(uint32_t cycles) {
+    cycles_per_frame = cycles > 0 ? cycles : 1;
+}
+
+uint32_t Chip8CPU::getCyclesPerFrame() const {
+    return cycles_per_frame;
+}
+
+void Chip8CPU::setClockHz(uint32_t hz) {
+    setCyclesPerFrame((hz + FRAME_RATE / 2) / FRAME_RATE);
+}
+
+bool parseEngineName(const std::string& name, Chip8Engine& engine) {
+    if (name == "interpreter") {
+        engine = Chip8Engine::INTERPRETER;
+    } else if (name == "threaded") {
+        engine = Chip8Engine::THREADED;
+    } else if (name == "jit") {
+        engine = Chip8Engine::JIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* engineName(Chip8Engine engine) {
+    switch (engine) {
+        case Chip8Engine::INTERPRETER:
+            return "interpreter";
+        case Chip8Engine::THREADED:
+            return "threaded";
+        case Chip8Engine::JIT:
+            return "jit";
+    }
+    return "unknown";
+}
+
+bool parseMemoryPolicyName(const std::string& name, MemoryPolicy& policy) {
+    if (name == "checked") {
+        policy = MemoryPolicy::CHECKED;
+    } else if (name == "masked") {
+        policy = MemoryPolicy::MASKED;
+    } else if (name == "trap") {
+        policy = MemoryPolicy::TRAPPING;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* memoryPolicyName(MemoryPolicy policy) {
+    switch (policy) {
+        case MemoryPolicy::CHECKED:
+            return "checked";
+        case MemoryPolicy::MASKED:
+            return "masked";
+        case MemoryPolicy::TRAPPING:
+            return "trap";
+    }
+    return "unknown";
+}
+
+bool Chip8CPU::setEngine(Chip8Engine engine) {
+    if (engine == Chip8Engine::JIT && !jit) {
+        auto candidate = std::make_unique<JitEngine>();
+        if (!candidate->isAvailable()) {
+            return false;
+        }
+        jit = std::move(candidate);
+        jit->setQuirks(quirksOf(quirk_profile));
+        observers.push_back(jit.get());
+    }
+    this->engine = engine;
+    return true;
+}
+
+Chip8Engine Chip8CPU::getEngine() const {
+    return engine;
+}
+
+void Chip8CPU::setMemoryPolicy(MemoryPolicy policy) {
+    memory_policy = policy;
+    // Decoded instructions point at the handlers of the old policy.
+    notifyWrite(0, Memory::MEM_SIZE);
+}
+
+MemoryPolicy Chip8CPU::getMemoryPolicy() const {
+    return memory_policy;
+}
+
+void Chip8CPU::setQuirkProfile(QuirkProfile profile) {
+    quirk_profile = profile;
+    extend_memory(quirksOf(profile).memory_size);
+    if (jit) {
+        jit->setQuirks(quirksOf(profile));
+    }
+    notifyWrite(0, Memory::MEM_SIZE);
+}
+
+QuirkProfile Chip8CPU::getQuirkProfile() const {
+    return quirk_profile;
+}
+
+const MemoryFault* Chip8CPU::getMemoryFault() const {
+    return faulted ? &fault : nullptr;
+}
+
+void Chip8CPU::clearMemoryFault() {
+    faulted = false;
+}
+
+void Chip8CPU::seedRandom(uint64_t seed) {
+    state.rng.seed(seed);
+}
+
+void Chip8CPU::setRandomSource(std::unique_ptr<RandomSource> source) {
+    random_source = std::move(source);
+}
+
+uint64_t Chip8CPU::getInstructionCount() const {
+    return instructions;
+}
+
+bool Chip8CPU::startTrace(const std::string& path, bool capture_registers) {
+#ifdef CHIP8_TRACE
+    auto candidate = std::make_unique<Tracer>();
+    if (!candidate->open(path, capture_registers)) {
+        return false;
+    }
+    tracer = std::move(candidate);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Chip8CPU::stopTrace() {
+#ifdef CHIP8_TRACE
+    tracer.reset();
+#endif
+}
+
+bool Chip8CPU::isWaitingForKey() const {
+    return state.key_waiting;
+}
+
+bool Chip8CPU::startRecording(const std::string& path) {
+    stopMovie();
+    MovieFileHeader header = {{'C', '8', 'M', 'V'},
+                              MOVIE_VERSION,
+                              static_cast<uint8_t>(quirk_profile),
+                              static_cast<uint8_t>(memory_policy),
+                              cycles_per_frame,
+                              sizeof(SaveState)};
+    auto start = std::make_unique<SaveState>();
+    captureState(*start);
+    auto candidate = std::make_unique<MovieRecorder>();
+    if (!candidate->open(path, header, *start)) {
+        return false;
+    }
+    recorder = std::move(candidate);
+    return true;
+}
+
+bool Chip8CPU::startReplay(const std::string& path) {
+    auto candidate = std::make_unique<MoviePlayer>();
+    if (!candidate->open(path) ||
+        candidate->header().quirk_profile >
+            static_cast<uint8_t>(QuirkProfile::XOCHIP) ||
+        candidate->header().memory_policy >
+            static_cast<uint8_t>(MemoryPolicy::TRAPPING) ||
+        !restoreState(candidate->start())) {
+        return false;
+    }
+    stopMovie();
+    setMemoryPolicy(
+        static_cast<MemoryPolicy>(candidate->header().memory_policy));
+    setQuirkProfile(
+        static_cast<QuirkProfile>(candidate->header().quirk_profile));
+    setCyclesPerFrame(candidate->header().cycles_per_frame);
+    player = std::move(candidate);
+    return true;
+}
+
+void Chip8CPU::stopMovie() {
+    recorder.reset();
+    player.reset();
+}
+
+bool Chip8CPU::isReplaying() const {
+    return player != nullptr;
+}
+
+void Chip8CPU::movie_frame() {
+    if (player) {
+        state.keys = player->frame();
+        if (player->finished()) {
+            player.reset();
+        }
+    } else if (recorder) {
+        recorder->frame(state.keys);
+    }
+}
+
+uint64_t Chip8CPU::execute(uint64_t max_cycles) {
+    if (faulted) {
+        return 0;
+    }
+    if (breakpoint_count == 0 && watch_count == 0) {
+        breakpoint_hit = false;
+        watch_stopped = false;
+        stopped_before = false;
+        return withCore(memory_policy, quirk_profile, [&](auto core) {
+            return execute_with<decltype(core)>(max_cycles);
+        });
+    }
+    return withCore(memory_policy, quirk_profile, [&](auto core) {
+        return execute_checked<decltype(core)>(max_cycles);
+    });
+}
+
+uint64_t Chip8CPU::step() {
+    if (faulted) {
+        return 0;
+    }
+    return withCore(memory_policy, quirk_profile, [&](auto core) {
+        return execute_checked<decltype(core)>(1);
+    });
+}
+
+void Chip8CPU::setBreakpoint(uint16_t address, bool enabled) {
+    if (!breakpoints) {
+        breakpoints = std::make_unique<uint64_t[]>(Memory::MEM_SIZE / 64);
+    }
+    uint64_t& word = breakpoints[address / 64];
+    uint64_t bit = uint64_t(1) << (address % 64);
+    breakpoint_count += enabled - ((word & bit) != 0);
+    word = enabled ? word | bit : word & ~bit;
+    breakpoint_conditions.erase(address);
+}
+
+void Chip8CPU::setBreakpoint(uint16_t address, const Condition& condition) {
+    setBreakpoint(address, true);
+    breakpoint_conditions[address] = condition;
+}
+
+bool Chip8CPU::hasBreakpoint(uint16_t address) const {
+    return breakpoints && ((breakpoints[address / 64] >> (address % 64)) & 1);
+}
+
+void Chip8CPU::clearBreakpoints() {
+    breakpoints.reset();
+    breakpoint_count = 0;
+    breakpoint_conditions.clear();
+    breakpoint_hit = false;
+}
+
+bool Chip8CPU::isAtBreakpoint() const {
+    return breakpoint_hit;
+}
+
+void Chip8CPU::setWatchpoint(uint16_t first, uint16_t last,
+                             MemoryFault::Kind kind, bool enabled) {
+    if (!watch_flags) {
+        watch_flags = std::make_unique<uint8_t[]>(Memory::MEM_SIZE);
+    }
+    uint8_t bit = uint8_t(1 << kind);
+    for (uint32_t address = first; address <= last; ++address) {
+        uint8_t& flags = watch_flags[address];
+        watch_count += enabled - ((flags & bit) != 0);
+        flags = enabled ? flags | bit : flags & ~bit;
+    }
+}
+
+void Chip8CPU::clearWatchpoints() {
+    watch_flags.reset();
+    watch_count = 0;
+    watch_stopped = false;
+}
+
+const WatchHit* Chip8CPU::getWatchHit() const {
+    return watch_stopped ? &watch_hit : nullptr;
+}
+
+void Chip8CPU::clearWatchHit() {
+    watch_stopped = false;
+}
+
+bool Chip8CPU::stops_at(uint16_t pc) {
+    if (breakpoints && ((breakpoints[pc / 64] >> (pc % 64)) & 1)) {
+        auto condition = breakpoint_conditions.find(pc);
+        if (condition == breakpoint_conditions.end() ||
+            condition->second.evaluate(state)) {
+            breakpoint_hit = true;
+            return true;
+        }
+    }
+    if (watch_flags && (watch_flags[pc] & (1 << MemoryFault::EXECUTE))) {
+        watch_hit = {pc, pc, MemoryFault::EXECUTE};
+        watch_stopped = true;
+        return true;
+    }
+    return false;
+}
+
+template <class Core>
+void Chip8CPU::watch_access(uint32_t address, size_t length,
+                            MemoryFault::Kind kind, uint16_t pc) {
+    // Instruction fetches go through the decode cache, so execute
+    // watchpoints are checked by PC in stops_at() instead.
+    if (kind == MemoryFault::EXECUTE || watch_stopped) {
+        return;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        uint32_t byte = uint32_t(address + i);
+        if (Memory::resolve<Core>(byte) && (watch_flags[byte] & (1 << kind))) {
+            watch_hit = {pc, byte, kind};
+            watch_stopped = true;
+            return;
+        }
+    }
+}
+
+template <class Core>
+uint64_t Chip8CPU::execute_checked(uint64_t max_cycles) {
+    uint64_t executed = 0;
+    // Leaving the breakpoint or watchpoint that stopped the last call.
+    bool resuming = stopped_before && state.reg.PC == stop_pc;
+    breakpoint_hit = false;
+    watch_stopped = false;
+    stopped_before = false;
+    while (executed < max_cycles) {
+        uint16_t pc = state.reg.PC;
+        if (!resuming && stops_at(pc)) {
+            stopped_before = true;
+            stop_pc = pc;
             break;
-        case 0x6000:  // 6XNN: LD Vx, byte
-            V[x] = nn;
+        }
+        resuming = false;
+        cycle_with<Core>();
+        if (Core::TRAPS && faulted) {
             break;
-        case 0x7000:  // 7XNN: ADD Vx, byte
-            V[x] += nn;
+        }
+        ++executed;
+        if (state.key_waiting || watch_stopped) {
             break;
-        case 0x8000:
-            switch (n) {
-                case 0x0:
-                    V[x] = V[y];
-                    break;  // 8XY0: LD Vx, Vy
-                case 0x1:
-                    V[x] |= V[y];
-                    break;  // 8XY1: OR Vx, Vy
-                case 0x2:
-                    V[x] &= V[y];
-                    break;  // 8XY2: AND Vx, Vy
-                case 0x3:
-                    V[x] ^= V[y];
-                    break;   // 8XY3: XOR Vx, Vy
-                case 0x4: {  // 8XY4: ADD Vx, Vy
-                    uint16_t sum = V[x] + V[y];
-                    V[0xF] = sum > 255;
-                    V[x] = sum & 0xFF;
-                    break;
-                }
-                case 0x5: {  // 8XY5: SUB Vx, Vy
-                    V[0xF] = V[x] > V[y];
-                    V[x] -= V[y];
-                    break;
-                }
-                case 0x6: {  // 8XY6: SHR Vx
-                    V[0xF] = V[x] & 0x1;
-                    V[x] >>= 1;
-                    break;
-                }
-                case 0x7: {  // 8XY7: SUBN Vx, Vy
-                    V[0xF] = V[y] > V[x];
-                    V[x] = V[y] - V[x];
+        }
+    }
+    return executed;
+}
+
+template <class Core>
+uint64_t Chip8CPU::execute_with(uint64_t max_cycles) {
+    uint64_t executed = 0;
+#ifdef CHIP8_TRACE
+    // Only cycle() records instructions one by one.
+    bool tracing = tracer != nullptr;
+#else
+    constexpr bool tracing = false;
+#endif
+    if (engine == Chip8Engine::JIT && !tracing) {
+        const uint8_t* memory = state.memory.bytes;
+        uint64_t native = 0;
+        while (executed < max_cycles) {
+            const JitBlock* block = jit->blockAt(state.reg.PC, memory);
+            if (block && block->length <= max_cycles - executed) {
+                block->code(&state.reg);
+                executed += block->length;
+                native += block->length;
+            } else {
+                cycle_with<Core>();
+                if (Core::TRAPS && faulted) {
                     break;
                 }
-                case 0xE: {  // 8XYE: SHL Vx
-                    V[0xF] = (V[x] & 0x80) >> 7;
-                    V[x] <<= 1;
+                ++executed;
+                if (state.key_waiting) {
                     break;
                 }
             }
+        }
+        instructions += native;
+        return executed;
+    }
+    if (engine == Chip8Engine::THREADED && !tracing) {
+        executed = execute_threaded<Core>(max_cycles);
+        instructions += executed;
+        return executed;
+    }
+    while (executed < max_cycles) {
+        cycle_with<Core>();
+        if (Core::TRAPS && faulted) {
             break;
-        case 0x9000:  // 9XY0: SNE Vx, Vy
-            if (V[x] != V[y]) PC += 2;
-            break;
-        case 0xA000:  // ANNN: LD I, addr
-            I = nnn;
-            break;
-        case 0xB000:  // BNNN: JP V0, addr
-            PC = nnn + V[0];
-            return;     // Return to avoid PC += 2
-        case 0xC000: {  // CXNN: RND Vx, byte
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<> distrib(0, 255);
-            V[x] = distrib(gen) & nn;
+        }
+        ++executed;
+        if (state.key_waiting) {
             break;
         }
-        case 0xD000: {  // DXYN: DRW Vx, Vy, nibble
-            if (display) {
-                const uint8_t* sprite = mem->getRawMemory() + I;
-                V[0xF] = display->drawSprite(V[x], V[y], sprite, n);
+    }
+    return executed;
+}
+
+uint64_t Chip8CPU::runFrames(uint64_t frames, uint32_t cycles_per_frame) {
+    uint64_t executed = 0;
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        movie_frame();
+        executed += execute(cycles_per_frame);
+        update_timers();
+    }
+    return executed;
+}
+
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;  // FNV-1a 64-bit prime
+    }
+}
+
+uint64_t Chip8CPU::stateHash() const {
+    uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a 64-bit offset basis
+    hashBytes(hash, state.memory.bytes, quirksOf(quirk_profile).memory_size);
+    hashBytes(hash, state.reg.V, sizeof state.reg.V);
+    hashBytes(hash, &state.reg.I, sizeof state.reg.I);
+    hashBytes(hash, &state.reg.PC, sizeof state.reg.PC);
+    hashBytes(hash, &state.reg.SP, sizeof state.reg.SP);
+    hashBytes(hash, &state.reg.delay_timer, sizeof state.reg.delay_timer);
+    hashBytes(hash, &state.reg.sound_timer, sizeof state.reg.sound_timer);
+    hashBytes(hash, state.stack, sizeof state.stack);
+    hashBytes(hash, state.rng.s, sizeof state.rng.s);
+    hashBytes(hash, state.rpl, sizeof state.rpl);
+    hashBytes(hash, state.audio_pattern, sizeof state.audio_pattern);
+    hashBytes(hash, &state.pitch, sizeof state.pitch);
+    hashBytes(hash, &state.key_waiting, sizeof state.key_waiting);
+    hashBytes(hash, &state.key_wait_ignored, sizeof state.key_wait_ignored);
+    hashBytes(hash, &state.key_wait_pressed, sizeof state.key_wait_pressed);
+    if (mode != Chip8Mode::TEST) {
+        const Framebuffer& display = state.display;
+        hashBytes(hash, display.planes, sizeof display.planes);
+        hashBytes(hash, &display.hires, sizeof display.hires);
+        hashBytes(hash, &display.plane_mask, sizeof display.plane_mask);
+    }
+    return hash;
+}
+
+void Chip8CPU::captureState(SaveState& saved) const {
+    std::memset(&saved, 0, offsetof(SaveState, machine));
+    std::memcpy(saved.magic, "C8SS", 4);
+    saved.version = SAVE_STATE_VERSION;
+    saved.size = sizeof(SaveState);
+    saved.memory_size = uint32_t(memory_extent);
+    saved.instructions = instructions;
+    if (mode != Chip8Mode::TEST) {
+        saved.flags |= SAVE_STATE_DISPLAY;
+    }
+    if (keypad) {
+        saved.flags |= SAVE_STATE_KEYPAD;
+    }
+    std::memcpy(&saved.machine, &state, state_bytes());
+}
+
+bool Chip8CPU::restoreState(const SaveState& saved) {
+    if (std::memcmp(saved.magic, "C8SS", 4) != 0 ||
+        saved.version != SAVE_STATE_VERSION || saved.size != sizeof saved ||
+        saved.memory_size > Memory::MEM_SIZE || saved.memory_size % 64) {
+        return false;
+    }
+    // Host-side parts the blob does not describe are kept.
+    Framebuffer display_rows = state.display;
+    uint16_t keys = state.keys;
+    memory_extent = saved.memory_size;
+    std::memcpy(&state, &saved.machine, state_bytes());
+    extend_memory(quirksOf(quirk_profile).memory_size);
+    if (!(saved.flags & SAVE_STATE_DISPLAY)) {
+        state.display = display_rows;
+    }
+    if (!(saved.flags & SAVE_STATE_KEYPAD)) {
+        state.keys = keys;
+    }
+    instructions = saved.instructions;
+    faulted = false;
+    notifyWrite(0, Memory::MEM_SIZE);
+    return true;
+}
+
+std::vector<uint8_t> Chip8CPU::saveState() const {
+    auto saved = std::make_unique<SaveState>();  // Unused memory stays zero
+    captureState(*saved);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(saved.get());
+    return std::vector<uint8_t>(bytes, bytes + sizeof(SaveState));
+}
+
+bool Chip8CPU::loadState(const std::vector<uint8_t>& blob) {
+    if (blob.size() != sizeof(SaveState)) {
+        return false;
+    }
+    auto saved = std::make_unique<SaveState>();
+    std::memcpy(saved.get(), blob.data(), sizeof(SaveState));
+    return restoreState(*saved);
+}
+
+void Chip8CPU::setRewindCapacity(size_t bytes) {
+    if (bytes == 0) {
+        rewind_buffer.reset();
+        rewind_scratch.reset();
+    } else {
+        rewind_buffer = std::make_unique<RewindBuffer>(bytes);
+        if (!rewind_scratch) {
+            rewind_scratch = std::make_unique<SaveState>();
+        }
+    }
+}
+
+void Chip8CPU::recordRewind() {
+    if (rewind_buffer) {
+        captureState(*rewind_scratch);
+        rewind_buffer->push(*rewind_scratch);
+    }
+}
+
+bool Chip8CPU::rewind() {
+    if (!rewind_buffer || recorder || player || !rewind_buffer->stepBack(*rewind_scratch)) {
+        return false;
+    }
+    return restoreState(*rewind_scratch);
+}
+
+bool Chip8CPU::setAudio(const AudioConfig& config) {
+    // Close the old device first, SDL may not open a second one.
+    audio.reset();
+    audio = std::make_unique<Chip8Audio>(config);
+    if (!audio->isOpen()) {
+        audio.reset();
+        return false;
+    }
+    return true;
+}
+
+void Chip8CPU::closeAudio() {
+    audio.reset();
+}
+
+const AudioStream* Chip8CPU::getAudio() const {
+    return audio ? &audio->stream() : nullptr;
+}
+
+const RewindBuffer* Chip8CPU::getRewindBuffer() const {
+    return rewind_buffer.get();
+}
+
+bool Chip8CPU::saveStateToFile(const std::string& path) const {
+    std::vector<uint8_t> blob = saveState();
+    std::ofstream file(path, std::ios::binary);
+    return file.write(reinterpret_cast<const char*>(blob.data()), blob.size())
+        .good();
+}
+
+bool Chip8CPU::loadStateFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> blob(sizeof(SaveState));
+    if (!file.read(reinterpret_cast<char*>(blob.data()), blob.size()) ||
+        file.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+    return loadState(blob);
+}
+
+const Framebuffer* Chip8CPU::getDisplay() const {
+    return mode == Chip8Mode::TEST ? nullptr : &state.display;
+}
+
+const MachineState& Chip8CPU::getState() const {
+    return state;
+}
+
+void Chip8CPU::setState(const MachineState& machine) {
+    state = machine;
+    memory_extent = Memory::MEM_SIZE;
+    faulted = false;
+    notifyWrite(0, Memory::MEM_SIZE);
+}
+
+void Chip8CPU::writeMemory(uint16_t address, const uint8_t* data,
+                           size_t length) {
+    if (address >= Memory::MEM_SIZE) {
+        return;
+    }
+    length = std::min(length, Memory::MEM_SIZE - address);
+    extend_memory(address + length);
+    std::memcpy(state.memory.bytes + address, data, length);
+    notifyWrite(address, length);
+}
+
+void Chip8CPU::extend_memory(size_t size) {
+    // Whole cache lines, so snapshots stay a whole number of words.
+    size = std::min((size + 63) & ~size_t(63), Memory::MEM_SIZE);
+    if (size > memory_extent) {
+        std::memset(state.memory.bytes + memory_extent, 0,
+                    size - memory_extent);
+        memory_extent = size;
+    }
+}
+
+size_t Chip8CPU::state_bytes() const {
+    return offsetof(MachineState, memory) + memory_extent;
+}
+
+void Chip8CPU::writeByte(uint16_t address, uint8_t value) {
+    writeMemory(address, &value, 1);
+}
+
+void Chip8CPU::notifyWrite(uint16_t address, size_t length) {
+    if (decode_cache->frozen.load(std::memory_order_acquire)) {
+        decode_cache = std::make_shared<DecodeCache>(*decode_cache);
+    }
+    decode_cache->invalidate(address, length);
+    for (MemoryObserver* observer : observers) {
+        observer->onMemoryWrite(address, length);
+    }
+}
+
+template <class Core>
+bool Chip8CPU::checkAccess(uint32_t address, size_t length,
+                           MemoryFault::Kind kind, uint16_t pc) {
+    if (Core::TRAPS && address + length > Core::MEMORY_SIZE) {
+        fault = {pc, address, kind};
+        faulted = true;
+        return false;
+    }
+    if (watch_count > 0) {
+        watch_access<Core>(address, length, kind, pc);
+    }
+    return true;
+}
+
+template <class Core>
+void Chip8CPU::storeBytes(uint32_t address, const uint8_t* data,
+                          size_t length) {
+    if (!Memory::resolve<Core>(address)) {
+        return;
+    }
+    size_t first = std::min<size_t>(length, Core::MEMORY_SIZE - address);
+    writeMemory(address, data, first);
+    if (Core::WRAPS && first < length) {
+        writeMemory(0, data + first, length - first);
+    }
+}
+
+void Chip8CPU::cycle() {
+    withCore(memory_policy, quirk_profile,
+             [&](auto core) { cycle_with<decltype(core)>(); });
+}
+
+template <class Core>
+void Chip8CPU::cycle_with() {
+    DecodedOp uncached;
+    const DecodedOp* op = lookup<Core>(state.reg.PC, uncached);
+
+#ifdef CHIP8_TRACE
+    TraceRecord record;
+    if (tracer) {
+        record.cycle = instructions;
+        record.pc = state.reg.PC;
+        record.opcode = op->opcode;
+    }
+#endif
+
+    state.reg.PC += 2;
+    op->handler(*this, *op);
+    if (Core::TRAPS && faulted) {
+        state.reg.PC = fault.pc;  // Not retired
+        return;
+    }
+    ++instructions;
+
+#ifdef CHIP8_TRACE
+    if (tracer) {
+        if (tracer->capturesRegisters()) {
+            record.i = state.reg.I;
+            record.vx = state.reg.V[op->x];
+            record.vf = state.reg.V[0xF];
+        } else {
+            record.i = record.vx = record.vf = 0;
+        }
+        tracer->record(record);
+    }
+#endif
+}
+
+template <class Core>
+const DecodedOp* Chip8CPU::lookup(uint16_t pc, DecodedOp& uncached) {
+    if (pc < Core::MEMORY_SIZE - 1) {
+        DecodedOp& slot = decode_cache->at(pc);
+        if (!slot.handler) {
+            if (decode_cache->frozen.load(std::memory_order_acquire)) {
+                uncached = decode<Core>(fetch<Core>(pc));
+                return &uncached;
             }
-            break;
+            decode_cache->fill(pc) = decode<Core>(fetch<Core>(pc));
         }
+        return &slot;
+    }
+    // The second byte lies outside memory, nothing worth caching.
+    uncached = decode<Core>(fetch<Core>(pc));
+    return &uncached;
+}
+
+template <class Core>
+uint16_t Chip8CPU::fetch(uint16_t address) {
+    if (!checkAccess<Core>(address, 2, MemoryFault::EXECUTE, address)) {
+        return 0;
+    }
+    uint8_t high_byte = state.memory.load<Core>(address);
+    uint8_t low_byte = state.memory.load<Core>(address + 1);
+    return (high_byte << 8) | low_byte;
+}
+
+// Indexed by OpKind.
+template <class Core>
+const DecodedOp::Handler
+    Chip8CPU::handlers[static_cast<size_t>(OpKind::COUNT)] = {
+    op_NOP,          op_00E0,         op_00EE,         op_1NNN,
+    op_2NNN,         op_3XNN<Core>,   op_4XNN<Core>,   op_5XY0<Core>,
+    op_6XNN,         op_7XNN,         op_8XY0,         op_8XY1<Core>,
+    op_8XY2<Core>,   op_8XY3<Core>,   op_8XY4,         op_8XY5,
+    op_8XY6<Core>,   op_8XY7,         op_8XYE<Core>,   op_9XY0<Core>,
+    op_ANNN,         op_BNNN<Core>,   op_CXNN,         op_DXYN<Core>,
+    op_EX9E<Core>,   op_EXA1<Core>,   op_FX07,         op_FX0A,
+    op_FX15,         op_FX18,         op_FX1E,         op_FX29,
+    op_FX33<Core>,   op_FX55<Core>,   op_FX65<Core>,   op_00CN,
+    op_00FB,         op_00FC,         op_00FD,         op_00FE,
+    op_00FF,         op_FX30,         op_FX75,         op_FX85,
+    op_00DN,         op_5XY2<Core>,   op_5XY3<Core>,   op_F000<Core>,
+    op_FN01,         op_F002<Core>,   op_FX3A,
+};
+
+static OpKind classify(uint16_t opcode) {
+    uint8_t nn = opcode & 0x00FF;
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            if ((opcode & 0xFFF0) == 0x00C0) return OpKind::SCD;
+            if ((opcode & 0xFFF0) == 0x00D0) return OpKind::SCU;
+            switch (opcode) {
+                case 0x00E0:
+                    return OpKind::CLS;
+                case 0x00EE:
+                    return OpKind::RET;
+                case 0x00FB:
+                    return OpKind::SCR;
+                case 0x00FC:
+                    return OpKind::SCL;
+                case 0x00FD:
+                    return OpKind::EXIT;
+                case 0x00FE:
+                    return OpKind::LOW;
+                case 0x00FF:
+                    return OpKind::HIGH;
+            }
+            return OpKind::NOP;
+        case 0x1000:
+            return OpKind::JP;
+        case 0x2000:
+            return OpKind::CALL;
+        case 0x3000:
+            return OpKind::SE_BYTE;
+        case 0x4000:
+            return OpKind::SNE_BYTE;
+        case 0x5000:
+            if ((opcode & 0x000F) == 0x2) return OpKind::SAVE;
+            if ((opcode & 0x000F) == 0x3) return OpKind::LOAD;
+            return OpKind::SE_REG;
+        case 0x6000:
+            return OpKind::LD_BYTE;
+        case 0x7000:
+            return OpKind::ADD_BYTE;
+        case 0x8000:
+            switch (opcode & 0x000F) {
+                case 0x0:
+                    return OpKind::LD_REG;
+                case 0x1:
+                    return OpKind::OR;
+                case 0x2:
+                    return OpKind::AND;
+                case 0x3:
+                    return OpKind::XOR;
+                case 0x4:
+                    return OpKind::ADD_REG;
+                case 0x5:
+                    return OpKind::SUB;
+                case 0x6:
+                    return OpKind::SHR;
+                case 0x7:
+                    return OpKind::SUBN;
+                case 0xE:
+                    return OpKind::SHL;
+            }
+            return OpKind::NOP;
+        case 0x9000:
+            return OpKind::SNE_REG;
+        case 0xA000:
+            return OpKind::LD_I;
+        case 0xB000:
+            return OpKind::JP_V0;
+        case 0xC000:
+            return OpKind::RND;
+        case 0xD000:
+            return OpKind::DRW;
         case 0xE000:
+            if (nn == 0x9E) return OpKind::SKP;
+            if (nn == 0xA1) return OpKind::SKNP;
+            return OpKind::NOP;
+        case 0xF000:
             switch (nn) {
-                case 0x9E:  // EX9E: SKP Vx
-                    if (keypad && keypad->isKeyPressed(V[x])) PC += 2;
+                case 0x00:
+                    if (opcode == 0xF000) return OpKind::LD_I_LONG;
                     break;
-                case 0xA1:  // EXA1: SKNP Vx
-                    if (keypad && !keypad->isKeyPressed(V[x])) PC += 2;
+                case 0x01:
+                    return OpKind::PLANE;
+                case 0x02:
+                    if (opcode == 0xF002) return OpKind::AUDIO;
                     break;
-            }
-            break;
-        case 0xF000:
-            switch (nn) {
                 case 0x07:
-                    V[x] = reg->delay_timer;
-                    break;  // FX07: LD Vx, DT
-                case 0x0A:  // FX0A: LD Vx, K
-                    if (keypad) {
-                        V[x] = keypad->waitForKey();
-                    } else {
-                        // In test mode, return a default value (e.g., 0)
-                        V[x] = 0;
-                    }
-                    break;
+                    return OpKind::LD_VX_DT;
+                case 0x0A:
+                    return OpKind::LD_VX_K;
                 case 0x15:
-                    reg->delay_timer = V[x];
-                    break;  // FX15: LD DT, Vx
+                    return OpKind::LD_DT_VX;
                 case 0x18:
-                    reg->sound_timer = V[x];
-                    break;  // FX18: LD ST, Vx
+                    return OpKind::LD_ST_VX;
                 case 0x1E:
-                    I += V[x];
-                    break;  // FX1E: ADD I, Vx
+                    return OpKind::ADD_I;
                 case 0x29:
-                    I = V[x] * 5;
-                    break;    // FX29: LD F, Vx (Fontset is at 0x0)
-                case 0x33: {  // FX33: LD B, Vx
-                    uint8_t val = V[x];
-                    mem->writeByte(I + 2, val % 10);
-                    val /= 10;
-                    mem->writeByte(I + 1, val % 10);
-                    val /= 10;
-                    mem->writeByte(I, val % 10);
-                    break;
-                }
-                case 0x55: {  // FX55: LD [I], Vx
-                    for (int i = 0; i <= x; ++i) {
-                        mem->writeByte(I + i, V[i]);
-                    }
-                    break;
-                }
-                case 0x65: {  // FX65: LD Vx, [I]
-                    for (int i = 0; i <= x; ++i) {
-                        V[i] = mem->readByte(I + i).value_or(0);
-                    }
-                    break;
-                }
+                    return OpKind::LD_F;
+                case 0x30:
+                    return OpKind::LD_HF;
+                case 0x33:
+                    return OpKind::LD_B;
+                case 0x3A:
+                    return OpKind::PITCH;
+                case 0x55:
+                    return OpKind::LD_MEM;
+                case 0x65:
+                    return OpKind::LD_REGS;
+                case 0x75:
+                    return OpKind::LD_R;
+                case 0x85:
+                    return OpKind::LD_VX_R;
+            }
+            return OpKind::NOP;
+    }
+    return OpKind::NOP;
+}
+
+template <class Core>
+DecodedOp Chip8CPU::decode(uint16_t opcode) {
+    DecodedOp op;
+    op.opcode = opcode;
+    op.nnn = opcode & 0x0FFF;
+    op.nn = opcode & 0x00FF;
+    op.x = (opcode & 0x0F00) >> 8;
+    op.y = (opcode & 0x00F0) >> 4;
+    op.kind = classify(opcode);
+    op.handler = handlers<Core>[static_cast<size_t>(op.kind)];
+    return op;
+}
+
+void Chip8CPU::op_NOP(Chip8CPU& cpu, const DecodedOp& op) {
+}
+
+void Chip8CPU::op_00E0(Chip8CPU& cpu, const DecodedOp& op) {  // CLS
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.clear();
+    }
+}
+
+void Chip8CPU::op_00EE(Chip8CPU& cpu, const DecodedOp& op) {  // RET
+    uint8_t& sp = cpu.state.reg.SP;
+    cpu.state.reg.PC = (sp > 0 ? cpu.state.stack[--sp] : 0) + 2;
+}
+
+void Chip8CPU::op_1NNN(Chip8CPU& cpu, const DecodedOp& op) {  // JP addr
+    cpu.state.reg.PC = op.nnn;
+}
+
+void Chip8CPU::op_2NNN(Chip8CPU& cpu, const DecodedOp& op) {  // CALL addr
+    uint8_t& sp = cpu.state.reg.SP;
+    if (sp < 16) {
+        cpu.state.stack[sp++] = cpu.state.reg.PC - 2;  // RET resumes after
+    }
+    cpu.state.reg.PC = op.nnn;
+}
+
+// Skips the next instruction, which is four bytes long if it is an XO-CHIP
+// F000 NNNN.
+template <class Core>
+static inline void skipNext(MachineState& state) {
+    uint16_t& pc = state.reg.PC;
+    if (Core::QUIRKS.long_skips && state.memory.load<Core>(pc) == 0xF0 &&
+        state.memory.load<Core>(pc + 1) == 0x00) {
+        pc += 2;
+    }
+    pc += 2;
+}
+
+template <class Core>
+void Chip8CPU::op_3XNN(Chip8CPU& cpu, const DecodedOp& op) {  // SE Vx, byte
+    if (cpu.state.reg.V[op.x] == op.nn) skipNext<Core>(cpu.state);
+}
+
+template <class Core>
+void Chip8CPU::op_4XNN(Chip8CPU& cpu, const DecodedOp& op) {  // SNE Vx, byte
+    if (cpu.state.reg.V[op.x] != op.nn) skipNext<Core>(cpu.state);
+}
+
+template <class Core>
+void Chip8CPU::op_5XY0(Chip8CPU& cpu, const DecodedOp& op) {  // SE Vx, Vy
+    if (cpu.state.reg.V[op.x] == cpu.state.reg.V[op.y]) {
+        skipNext<Core>(cpu.state);
+    }
+}
+
+void Chip8CPU::op_6XNN(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, byte
+    cpu.state.reg.V[op.x] = op.nn;
+}
+
+void Chip8CPU::op_7XNN(Chip8CPU& cpu, const DecodedOp& op) {  // ADD Vx, byte
+    cpu.state.reg.V[op.x] += op.nn;
+}
+
+void Chip8CPU::op_8XY0(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, Vy
+    cpu.state.reg.V[op.x] = cpu.state.reg.V[op.y];
+}
+
+template <class Core>
+void Chip8CPU::op_8XY1(Chip8CPU& cpu, const DecodedOp& op) {  // OR Vx, Vy
+    cpu.state.reg.V[op.x] |= cpu.state.reg.V[op.y];
+    if (Core::QUIRKS.logic_resets_vf) {
+        cpu.state.reg.V[0xF] = 0;
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_8XY2(Chip8CPU& cpu, const DecodedOp& op) {  // AND Vx, Vy
+    cpu.state.reg.V[op.x] &= cpu.state.reg.V[op.y];
+    if (Core::QUIRKS.logic_resets_vf) {
+        cpu.state.reg.V[0xF] = 0;
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_8XY3(Chip8CPU& cpu, const DecodedOp& op) {  // XOR Vx, Vy
+    cpu.state.reg.V[op.x] ^= cpu.state.reg.V[op.y];
+    if (Core::QUIRKS.logic_resets_vf) {
+        cpu.state.reg.V[0xF] = 0;
+    }
+}
+
+void Chip8CPU::op_8XY4(Chip8CPU& cpu, const DecodedOp& op) {  // ADD Vx, Vy
+    auto& V = cpu.state.reg.V;
+    uint16_t sum = V[op.x] + V[op.y];
+    V[0xF] = sum > 255;
+    V[op.x] = sum & 0xFF;
+}
+
+void Chip8CPU::op_8XY5(Chip8CPU& cpu, const DecodedOp& op) {  // SUB Vx, Vy
+    auto& V = cpu.state.reg.V;
+    V[0xF] = V[op.x] > V[op.y];
+    V[op.x] -= V[op.y];
+}
+
+template <class Core>
+void Chip8CPU::op_8XY6(Chip8CPU& cpu, const DecodedOp& op) {  // SHR Vx
+    auto& V = cpu.state.reg.V;
+    const uint8_t& source = V[Core::QUIRKS.shift_vy ? op.y : op.x];
+    V[0xF] = source & 0x1;
+    V[op.x] = source >> 1;
+}
+
+void Chip8CPU::op_8XY7(Chip8CPU& cpu, const DecodedOp& op) {  // SUBN Vx, Vy
+    auto& V = cpu.state.reg.V;
+    V[0xF] = V[op.y] > V[op.x];
+    V[op.x] = V[op.y] - V[op.x];
+}
+
+template <class Core>
+void Chip8CPU::op_8XYE(Chip8CPU& cpu, const DecodedOp& op) {  // SHL Vx
+    auto& V = cpu.state.reg.V;
+    const uint8_t& source = V[Core::QUIRKS.shift_vy ? op.y : op.x];
+    V[0xF] = (source & 0x80) >> 7;
+    V[op.x] = source << 1;
+}
+
+template <class Core>
+void Chip8CPU::op_9XY0(Chip8CPU& cpu, const DecodedOp& op) {  // SNE Vx, Vy
+    if (cpu.state.reg.V[op.x] != cpu.state.reg.V[op.y]) {
+        skipNext<Core>(cpu.state);
+    }
+}
+
+void Chip8CPU::op_ANNN(Chip8CPU& cpu, const DecodedOp& op) {  // LD I, addr
+    cpu.state.reg.I = op.nnn;
+}
+
+template <class Core>
+void Chip8CPU::op_BNNN(Chip8CPU& cpu, const DecodedOp& op) {  // JP V0, addr
+    uint8_t offset = cpu.state.reg.V[Core::QUIRKS.jump_vx ? op.x : 0];
+    cpu.state.reg.PC = op.nnn + offset;
+}
+
+void Chip8CPU::op_CXNN(Chip8CPU& cpu, const DecodedOp& op) {  // RND Vx, byte
+    uint8_t value = cpu.random_source ? cpu.random_source->nextByte()
+                                      : cpu.state.rng.nextByte();
+    cpu.state.reg.V[op.x] = value & op.nn;
+}
+
+template <class Core>
+void Chip8CPU::op_DXYN(Chip8CPU& cpu, const DecodedOp& op) {  // DRW Vx, Vy, n
+    if (cpu.mode != Chip8Mode::TEST) {
+        auto& V = cpu.state.reg.V;
+        uint32_t I = cpu.state.reg.I;
+        uint8_t n = op.opcode & 0x000F;
+        bool wide = n == 0;  // SCHIP DXY0: 16x16, two bytes per row
+        // One sprite per selected XO-CHIP plane, back to back.
+        uint8_t length = (wide ? 32 : n) * cpu.state.display.selectedPlanes();
+        if (!cpu.checkAccess<Core>(I, length, MemoryFault::READ,
+                                     cpu.state.reg.PC - 2)) {
+            return;
+        }
+        const uint8_t* sprite = cpu.state.memory.bytes + I;
+        uint8_t rows[32 * Framebuffer::PLANES];
+        if (I + length > Core::MEMORY_SIZE) {  // Gather what the policy allows
+            for (uint8_t i = 0; i < length; ++i) {
+                rows[i] = cpu.state.memory.load<Core>(I + i);
             }
+            sprite = rows;
+        }
+        int height = wide ? 16 : n;
+        V[0xF] = Core::QUIRKS.clip_sprites
+                     ? cpu.state.display.drawSpriteClipped(
+                           V[op.x], V[op.y], sprite, height, wide)
+                     : cpu.state.display.drawSprite(V[op.x], V[op.y], sprite,
+                                                    height, wide);
+    }
+}
+
+static inline bool isKeyDown(uint16_t keys, uint8_t key) {
+    return key < 16 && ((keys >> key) & 1);
+}
+
+template <class Core>
+void Chip8CPU::op_EX9E(Chip8CPU& cpu, const DecodedOp& op) {  // SKP Vx
+    if (cpu.mode != Chip8Mode::TEST && isKeyDown(cpu.state.keys, cpu.state.reg.V[op.x])) {
+        skipNext<Core>(cpu.state);
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_EXA1(Chip8CPU& cpu, const DecodedOp& op) {  // SKNP Vx
+    if (cpu.mode != Chip8Mode::TEST && !isKeyDown(cpu.state.keys, cpu.state.reg.V[op.x])) {
+        skipNext<Core>(cpu.state);
+    }
+}
+
+void Chip8CPU::op_FX07(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, DT
+    cpu.state.reg.V[op.x] = cpu.state.reg.delay_timer;
+}
+
+void Chip8CPU::op_FX0A(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, K
+    MachineState& state = cpu.state;
+    if (cpu.mode == Chip8Mode::TEST) {
+        state.reg.V[op.x] = 0;
+        return;
+    }
+    // A press and release, as on the COSMAC VIP. Until then the instruction
+    // re-executes once per execute() call, which returns right after it.
+    if (!state.key_waiting) {
+        state.key_waiting = true;
+        state.key_wait_ignored = state.keys;
+        state.key_wait_pressed = 0;
+    }
+    state.key_wait_ignored &= state.keys;
+    state.key_wait_pressed |= state.keys & ~state.key_wait_ignored;
+    uint16_t released = state.key_wait_pressed & ~state.keys;
+    if (released == 0) {
+        state.reg.PC -= 2;
+        return;
+    }
+    uint8_t key = 0;
+    while (!((released >> key) & 1)) {
+        ++key;
+    }
+    state.reg.V[op.x] = key;
+    state.key_waiting = false;
+}
+
+void Chip8CPU::op_FX15(Chip8CPU& cpu, const DecodedOp& op) {  // LD DT, Vx
+    cpu.state.reg.delay_timer = cpu.state.reg.V[op.x];
+}
+
+void Chip8CPU::op_FX18(Chip8CPU& cpu, const DecodedOp& op) {  // LD ST, Vx
+    cpu.state.reg.sound_timer = cpu.state.reg.V[op.x];
+}
+
+void Chip8CPU::op_FX1E(Chip8CPU& cpu, const DecodedOp& op) {  // ADD I, Vx
+    cpu.state.reg.I += cpu.state.reg.V[op.x];
+}
+
+void Chip8CPU::op_FX29(Chip8CPU& cpu, const DecodedOp& op) {  // LD F, Vx
+    cpu.state.reg.I = cpu.state.reg.V[op.x] * 5;  // Fontset is at 0x0
+}
+
+template <class Core>
+void Chip8CPU::op_FX33(Chip8CPU& cpu, const DecodedOp& op) {  // LD B, Vx
+    uint32_t I = cpu.state.reg.I;
+    uint8_t val = cpu.state.reg.V[op.x];
+    uint8_t digits[3] = {uint8_t(val / 100), uint8_t(val / 10 % 10),
+                         uint8_t(val % 10)};
+    if (cpu.checkAccess<Core>(I, 3, MemoryFault::WRITE,
+                                cpu.state.reg.PC - 2)) {
+        cpu.storeBytes<Core>(I, digits, 3);
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_FX55(Chip8CPU& cpu, const DecodedOp& op) {  // LD [I], Vx
+    uint32_t I = cpu.state.reg.I;
+    if (cpu.checkAccess<Core>(I, op.x + 1, MemoryFault::WRITE,
+                                cpu.state.reg.PC - 2)) {
+        cpu.storeBytes<Core>(I, cpu.state.reg.V, op.x + 1);
+        if (Core::QUIRKS.increment_i) {
+            cpu.state.reg.I += op.x + 1;
+        }
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_FX65(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, [I]
+    uint32_t I = cpu.state.reg.I;
+    if (!cpu.checkAccess<Core>(I, op.x + 1, MemoryFault::READ,
+                                 cpu.state.reg.PC - 2)) {
+        return;
+    }
+    for (int i = 0; i <= op.x; ++i) {
+        cpu.state.reg.V[i] = cpu.state.memory.load<Core>(I + i);
+    }
+    if (Core::QUIRKS.increment_i) {
+        cpu.state.reg.I += op.x + 1;
+    }
+}
+
+void Chip8CPU::op_00CN(Chip8CPU& cpu, const DecodedOp& op) {  // SCD n
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.scrollDown(op.opcode & 0x000F);
+    }
+}
+
+void Chip8CPU::op_00FB(Chip8CPU& cpu, const DecodedOp& op) {  // SCR
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.scrollRight(4);
+    }
+}
+
+void Chip8CPU::op_00FC(Chip8CPU& cpu, const DecodedOp& op) {  // SCL
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.scrollLeft(4);
+    }
+}
+
+void Chip8CPU::op_00FD(Chip8CPU& cpu, const DecodedOp& op) {  // EXIT
+    cpu.state.reg.PC -= 2;  // Halt by spinning on this instruction
+}
+
+void Chip8CPU::op_00FE(Chip8CPU& cpu, const DecodedOp& op) {  // LOW
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.hires = false;
+    }
+}
+
+void Chip8CPU::op_00FF(Chip8CPU& cpu, const DecodedOp& op) {  // HIGH
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.hires = true;
+    }
+}
+
+void Chip8CPU::op_FX30(Chip8CPU& cpu, const DecodedOp& op) {  // LD HF, Vx
+    cpu.state.reg.I =
+        Memory::LARGE_FONT_ADDR + (cpu.state.reg.V[op.x] & 0xF) * 10;
+}
+
+void Chip8CPU::op_FX75(Chip8CPU& cpu, const DecodedOp& op) {  // LD R, Vx
+    std::memcpy(cpu.state.rpl, cpu.state.reg.V, op.x + 1);
+}
+
+void Chip8CPU::op_FX85(Chip8CPU& cpu, const DecodedOp& op) {  // LD Vx, R
+    std::memcpy(cpu.state.reg.V, cpu.state.rpl, op.x + 1);
+}
+
+void Chip8CPU::op_00DN(Chip8CPU& cpu, const DecodedOp& op) {  // SCU n
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.scrollUp(op.opcode & 0x000F);
+    }
+}
+
+// The registers from Vx to Vy, counting down if x > y.
+static int registerRange(const DecodedOp& op, uint8_t* order) {
+    int step = op.x <= op.y ? 1 : -1;
+    int count = (op.y - op.x) * step + 1;
+    for (int i = 0; i < count; ++i) {
+        order[i] = op.x + i * step;
+    }
+    return count;
+}
+
+template <class Core>
+void Chip8CPU::op_5XY2(Chip8CPU& cpu, const DecodedOp& op) {  // SAVE Vx-Vy
+    uint8_t order[16];
+    uint8_t values[16];
+    int count = registerRange(op, order);
+    for (int i = 0; i < count; ++i) {
+        values[i] = cpu.state.reg.V[order[i]];
+    }
+    uint32_t I = cpu.state.reg.I;
+    if (cpu.checkAccess<Core>(I, count, MemoryFault::WRITE,
+                                cpu.state.reg.PC - 2)) {
+        cpu.storeBytes<Core>(I, values, count);
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_5XY3(Chip8CPU& cpu, const DecodedOp& op) {  // LOAD Vx-Vy
+    uint8_t order[16];
+    int count = registerRange(op, order);
+    uint32_t I = cpu.state.reg.I;
+    if (!cpu.checkAccess<Core>(I, count, MemoryFault::READ,
+                                 cpu.state.reg.PC - 2)) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        cpu.state.reg.V[order[i]] = cpu.state.memory.load<Core>(I + i);
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_F000(Chip8CPU& cpu, const DecodedOp& op) {  // LD I, long
+    // The address is the next word, which PC steps over.
+    uint32_t pc = cpu.state.reg.PC;
+    if (!cpu.checkAccess<Core>(pc, 2, MemoryFault::READ, pc - 2)) {
+        return;
+    }
+    cpu.state.reg.I = (cpu.state.memory.load<Core>(pc) << 8) |
+                      cpu.state.memory.load<Core>(pc + 1);
+    cpu.state.reg.PC += 2;
+}
+
+void Chip8CPU::op_FN01(Chip8CPU& cpu, const DecodedOp& op) {  // PLANE n
+    if (cpu.mode != Chip8Mode::TEST) {
+        cpu.state.display.plane_mask = op.x;
+    }
+}
+
+template <class Core>
+void Chip8CPU::op_F002(Chip8CPU& cpu, const DecodedOp& op) {  // AUDIO
+    uint32_t I = cpu.state.reg.I;
+    uint8_t* pattern = cpu.state.audio_pattern;
+    if (!cpu.checkAccess<Core>(I, sizeof cpu.state.audio_pattern,
+                                 MemoryFault::READ, cpu.state.reg.PC - 2)) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof cpu.state.audio_pattern; ++i) {
+        pattern[i] = cpu.state.memory.load<Core>(I + i);
+    }
+}
+
+void Chip8CPU::op_FX3A(Chip8CPU& cpu, const DecodedOp& op) {  // PITCH Vx
+    cpu.state.pitch = cpu.state.reg.V[op.x];
+}
+
+#if defined(__GNUC__) && !defined(CHIP8_NO_COMPUTED_GOTO)
+#define CHIP8_COMPUTED_GOTO 1
+#endif
+
+template <class Core>
+uint64_t Chip8CPU::execute_threaded(uint64_t max_cycles) {
+    uint64_t executed = 0;
+    DecodedOp uncached;
+    const DecodedOp* op;
+#ifdef CHIP8_COMPUTED_GOTO
+    // Direct-threaded dispatch: every handler body ends in its own indirect
+    // jump, so each one gets a separate branch predictor entry. Indexed by
+    // OpKind, like handlers[].
+    static const void* const labels[] = {
+        &&L_NOP,      &&L_CLS,      &&L_RET,      &&L_JP,       &&L_CALL,
+        &&L_SE_BYTE,  &&L_SNE_BYTE, &&L_SE_REG,   &&L_LD_BYTE,  &&L_ADD_BYTE,
+        &&L_LD_REG,   &&L_OR,       &&L_AND,      &&L_XOR,      &&L_ADD_REG,
+        &&L_SUB,      &&L_SHR,      &&L_SUBN,     &&L_SHL,      &&L_SNE_REG,
+        &&L_LD_I,     &&L_JP_V0,    &&L_RND,      &&L_DRW,      &&L_SKP,
+        &&L_SKNP,     &&L_LD_VX_DT, &&L_LD_VX_K,  &&L_LD_DT_VX, &&L_LD_ST_VX,
+        &&L_ADD_I,    &&L_LD_F,     &&L_LD_B,     &&L_LD_MEM,   &&L_LD_REGS,
+        &&L_SCD,      &&L_SCR,      &&L_SCL,      &&L_EXIT,     &&L_LOW,
+        &&L_HIGH,     &&L_LD_HF,    &&L_LD_R,     &&L_LD_VX_R,  &&L_SCU,
+        &&L_SAVE,     &&L_LOAD,     &&L_LD_I_LONG, &&L_PLANE,   &&L_AUDIO,
+        &&L_PITCH,
+    };
+    static_assert(sizeof(labels) / sizeof(labels[0]) ==
+                      static_cast<size_t>(OpKind::COUNT),
+                  "one label per OpKind");
+
+#define DISPATCH()                                    \
+    do {                                              \
+        if (Core::TRAPS && faulted) {               \
+            state.reg.PC = fault.pc;                  \
+            return executed - 1;                      \
+        }                                             \
+        if (executed == max_cycles) return executed;  \
+        op = lookup<Core>(state.reg.PC, uncached);  \
+        state.reg.PC += 2;                            \
+        ++executed;                                   \
+        goto* labels[static_cast<size_t>(op->kind)];  \
+    } while (0)
+
+    DISPATCH();
+L_NOP:
+    DISPATCH();
+L_CLS:
+    op_00E0(*this, *op);
+    DISPATCH();
+L_RET:
+    op_00EE(*this, *op);
+    DISPATCH();
+L_JP:
+    op_1NNN(*this, *op);
+    DISPATCH();
+L_CALL:
+    op_2NNN(*this, *op);
+    DISPATCH();
+L_SE_BYTE:
+    op_3XNN<Core>(*this, *op);
+    DISPATCH();
+L_SNE_BYTE:
+    op_4XNN<Core>(*this, *op);
+    DISPATCH();
+L_SE_REG:
+    op_5XY0<Core>(*this, *op);
+    DISPATCH();
+L_LD_BYTE:
+    op_6XNN(*this, *op);
+    DISPATCH();
+L_ADD_BYTE:
+    op_7XNN(*this, *op);
+    DISPATCH();
+L_LD_REG:
+    op_8XY0(*this, *op);
+    DISPATCH();
+L_OR:
+    op_8XY1<Core>(*this, *op);
+    DISPATCH();
+L_AND:
+    op_8XY2<Core>(*this, *op);
+    DISPATCH();
+L_XOR:
+    op_8XY3<Core>(*this, *op);
+    DISPATCH();
+L_ADD_REG:
+    op_8XY4(*this, *op);
+    DISPATCH();
+L_SUB:
+    op_8XY5(*this, *op);
+    DISPATCH();
+L_SHR:
+    op_8XY6<Core>(*this, *op);
+    DISPATCH();
+L_SUBN:
+    op_8XY7(*this, *op);
+    DISPATCH();
+L_SHL:
+    op_8XYE<Core>(*this, *op);
+    DISPATCH();
+L_SNE_REG:
+    op_9XY0<Core>(*this, *op);
+    DISPATCH();
+L_LD_I:
+    op_ANNN(*this, *op);
+    DISPATCH();
+L_JP_V0:
+    op_BNNN<Core>(*this, *op);
+    DISPATCH();
+L_RND:
+    op_CXNN(*this, *op);
+    DISPATCH();
+L_DRW:
+    op_DXYN<Core>(*this, *op);
+    DISPATCH();
+L_SKP:
+    op_EX9E<Core>(*this, *op);
+    DISPATCH();
+L_SKNP:
+    op_EXA1<Core>(*this, *op);
+    DISPATCH();
+L_LD_VX_DT:
+    op_FX07(*this, *op);
+    DISPATCH();
+L_LD_VX_K:
+    op_FX0A(*this, *op);
+    if (state.key_waiting) {
+        return executed;
+    }
+    DISPATCH();
+L_LD_DT_VX:
+    op_FX15(*this, *op);
+    DISPATCH();
+L_LD_ST_VX:
+    op_FX18(*this, *op);
+    DISPATCH();
+L_ADD_I:
+    op_FX1E(*this, *op);
+    DISPATCH();
+L_LD_F:
+    op_FX29(*this, *op);
+    DISPATCH();
+L_LD_B:
+    op_FX33<Core>(*this, *op);
+    DISPATCH();
+L_LD_MEM:
+    op_FX55<Core>(*this, *op);
+    DISPATCH();
+L_LD_REGS:
+    op_FX65<Core>(*this, *op);
+    DISPATCH();
+L_SCD:
+    op_00CN(*this, *op);
+    DISPATCH();
+L_SCR:
+    op_00FB(*this, *op);
+    DISPATCH();
+L_SCL:
+    op_00FC(*this, *op);
+    DISPATCH();
+L_EXIT:
+    op_00FD(*this, *op);
+    DISPATCH();
+L_LOW:
+    op_00FE(*this, *op);
+    DISPATCH();
+L_HIGH:
+    op_00FF(*this, *op);
+    DISPATCH();
+L_LD_HF:
+    op_FX30(*this, *op);
+    DISPATCH();
+L_LD_R:
+    op_FX75(*this, *op);
+    DISPATCH();
+L_LD_VX_R:
+    op_FX85(*this, *op);
+    DISPATCH();
+L_SCU:
+    op_00DN(*this, *op);
+    DISPATCH();
+L_SAVE:
+    op_5XY2<Core>(*this, *op);
+    DISPATCH();
+L_LOAD:
+    op_5XY3<Core>(*this, *op);
+    DISPATCH();
+L_LD_I_LONG:
+    op_F000<Core>(*this, *op);
+    DISPATCH();
+L_PLANE:
+    op_FN01(*this, *op);
+    DISPATCH();
+L_AUDIO:
+    op_F002<Core>(*this, *op);
+    DISPATCH();
+L_PITCH:
+    op_FX3A(*this, *op);
+    DISPATCH();
+#undef DISPATCH
+#else
+    // Portable fallback: one indirect call per instruction through the
+    // handler stored in the decoded slot.
+    while (executed < max_cycles) {
+        op = lookup<Core>(state.reg.PC, uncached);
+        state.reg.PC += 2;
+        op->handler(*this, *op);
+        if (Core::TRAPS && faulted) {
+            state.reg.PC = fault.pc;
             break;
-        default:
-            // Unknown opcode
+        }
+        ++executed;
+        if (state.key_waiting) {
             break;
+        }
     }
-
-    PC += 2;
+    return executed;
+#endif
 }
 
 bool Chip8CPU::loadROM(const std::string& filename) {
-    return mem->loadROM(filename);
+    std::shared_ptr<const RomImage> image = RomCache::global().load(filename);
+    if (!image) {
+        return false;
+    }
+    // Past the ROM the boot image is zero, which clears what was in use.
+    writeMemory(0, image->boot.bytes,
+                std::max(Memory::ROM_START_ADDR + image->size, memory_extent));
+    return true;
 }
 
 void Chip8CPU::update_timers() {
-    if (reg->delay_timer > 0) {
-        reg->delay_timer--;
+    if (audio) {
+        audio->stream().submitFrame(state.reg.sound_timer > 0,
+                                    state.audio_pattern, state.pitch);
+    }
+    if (state.reg.delay_timer > 0) {
+        state.reg.delay_timer--;
     }
-    if (reg->sound_timer > 0) {
-        reg->sound_timer--;
-        // TODO: Add sound output logic here
+    if (state.reg.sound_timer > 0) {
+        state.reg.sound_timer--;
     }
 }
 
 bool Chip8CPU::handle_input() {
     if (keypad) {
-        return keypad->handleInput();
+        return keypad->handleInput(state.keys);
     }
     return false;
 }
 
 void Chip8CPU::render() {
     if (display) {
-        display->render();
+        display->render(state.display);
     }
 }
 
@@ -1,16 +1,84 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
+#include "audio.hpp"
+#include "condition.hpp"
+#include "decode_cache.hpp"
 #include "display.hpp"
 #include "input.hpp"
-#include "memory.hpp"
-#include "register.hpp"
-#include "stack.hpp"
+#include "jit.hpp"
+#include "machine_state.hpp"
+#include "movie.hpp"
+#include "quirks.hpp"
+#include "rewind.hpp"
+#include "rng.hpp"
+#include "rom_cache.hpp"
+#include "save_state.hpp"
 #include "test_access.hpp"
+#include "trace.hpp"
 
 namespace CHIP8 {
-enum class Chip8Mode { NORMAL, TEST };
+// NORMAL opens a window and reads the keyboard, HEADLESS keeps an emulated
+// display without a window and has no keypad, TEST has neither.
+enum class Chip8Mode { NORMAL, HEADLESS, TEST };
+enum class Chip8Engine { INTERPRETER, THREADED, JIT };
+
+/**
+ * @brief Parses "interpreter", "threaded" or "jit".
+ *
+ * @return False if `name` is not an engine name.
+ */
+bool parseEngineName(const std::string& name, Chip8Engine& engine);
+const char* engineName(Chip8Engine engine);
+
+/**
+ * @brief Parses "checked", "masked" or "trap".
+ *
+ * @return False if `name` is not a memory policy name.
+ */
+bool parseMemoryPolicyName(const std::string& name, MemoryPolicy& policy);
+const char* memoryPolicyName(MemoryPolicy policy);
+
+/**
+ * @brief An out-of-range access stopped by MemoryPolicy::TRAPPING.
+ */
+struct MemoryFault {
+    enum Kind : uint8_t { READ, WRITE, EXECUTE };
+
+    uint16_t pc;       // The faulting instruction, where PC is left
+    uint32_t address;  // First byte of the access
+    Kind kind;
+};
+
+/**
+ * @brief A memory access by an instruction that hit a watchpoint.
+ */
+struct WatchHit {
+    uint16_t pc;       // The accessing instruction
+    uint32_t address;  // The watched byte
+    MemoryFault::Kind kind;
+};
+
+/**
+ * @brief Where the time of the last Chip8CPU::run() went.
+ */
+// input_seconds and render_seconds are spent on the presenting thread, the
+// other times on the emulation thread.
+struct RunStats {
+    uint64_t instructions = 0;
+    uint64_t frames = 0;  // Emulated 60 Hz frames, not counting rewound ones
+    double wall_seconds = 0;
+    double cpu_seconds = 0;  // execute()
+    double timer_seconds = 0;
+    double input_seconds = 0;
+    double render_seconds = 0;
+    double rewind_seconds = 0;  // Recording and replaying snapshots
+    double sleep_seconds = 0;  // Waiting for frame deadlines
+};
+
 class Chip8CPU {
 public:
     Chip8CPU();
@@ -23,22 +91,504 @@ public:
 
     Chip8CPU(Chip8Mode mode, const std::string& rom_path);
 
+    /**
+     * @brief Boots from an image returned by RomCache, without touching the
+     * file system. The fast way to start many instances of one ROM.
+     */
+    Chip8CPU(Chip8Mode mode, const RomImage& image);
+
     ~Chip8CPU() = default;
+
+    /**
+     * @brief Clones the running machine for search workloads.
+     *
+     * The child gets its own copy of the machine state and shares the
+     * parent's decoded instructions copy-on-write, so a fork costs about
+     * one copy of the MachineState up to the memory in use, some 4.4 KB
+     * outside XO-CHIP. It has no window or keyboard: a fork of a NORMAL
+     * machine is HEADLESS and is driven through setKeys(). It also starts
+     * without rewind history, trace or RandomSource. A JIT parent's
+     * children use the threaded engine, because each JIT owns a large
+     * executable code buffer.
+     */
+    Chip8CPU fork() const;
+
+    /**
+     * @brief The pressed keys, bit n for key n. In NORMAL mode the keyboard
+     * updates them as well.
+     */
+    void setKeys(uint16_t keys);
+    uint16_t getKeys() const;
+
+    /**
+     * @brief Runs the machine in real time until the window is closed.
+     *
+     * Emulation gets a thread of its own: every 1/60 s frame executes
+     * getCyclesPerFrame() instructions, ticks the timers once and publishes
+     * the framebuffer, then sleeps until the next frame deadline. The
+     * calling thread polls input and presents the newest published frame
+     * once per real 1/60 s, so a stall in either never holds up the other.
+     * The emulated result does not depend on the host. In turbo mode
+     * frames run back to back without sleeping.
+     */
     void run();
 
+    /**
+     * @brief Unthrottled run(): timers still tick once per emulated frame,
+     * so they follow the instruction count rather than the wall clock.
+     */
+    void setTurbo(bool enabled);
+    bool getTurbo() const;
+
+    /**
+     * @brief Counters and per-subsystem times of the last run().
+     */
+    const RunStats& getRunStats() const;
+
+    /**
+     * @brief Instructions executed per 60 Hz frame by run().
+     */
+    void setCyclesPerFrame(uint32_t cycles);
+    uint32_t getCyclesPerFrame() const;
+
+    /**
+     * @brief Sets the CPU speed in instructions per second, rounded to a
+     * whole number of instructions per frame.
+     */
+    void setClockHz(uint32_t hz);
+
+    /**
+     * @brief Selects the engine used by execute() and run().
+     *
+     * @return False if the engine is not supported on this host, in which
+     * case the current engine is kept.
+     */
+    bool setEngine(Chip8Engine engine);
+    Chip8Engine getEngine() const;
+
+    /**
+     * @brief Selects how every engine treats addresses past the end of
+     * the address space, 4 KB or 64 KB for XO-CHIP. Defaults to CHECKED,
+     * which keeps the results of existing ROMs; MASKED is the fastest and
+     * TRAPPING is meant for debugging.
+     */
+    void setMemoryPolicy(MemoryPolicy policy);
+    MemoryPolicy getMemoryPolicy() const;
+
+    /**
+     * @brief Selects the behaviours that differ between CHIP-8 variants.
+     * Every profile has its own specialised core, as every memory policy
+     * does. XOCHIP also opens up the 64 KB address space.
+     */
+    void setQuirkProfile(QuirkProfile profile);
+    QuirkProfile getQuirkProfile() const;
+
+    /**
+     * @brief The fault that stopped execution under TRAPPING, nullptr if
+     * there is none. execute() runs nothing until it is cleared.
+     */
+    const MemoryFault* getMemoryFault() const;
+    void clearMemoryFault();
+
+    /**
+     * @brief Executes up to `max_cycles` instructions with the selected
+     * engine. Timers are not touched.
+     *
+     * @return The number of instructions executed, fewer than `max_cycles`
+     * if one of them raised a MemoryFault, an FX0A is waiting for a key or
+     * a breakpoint was reached.
+     */
+    uint64_t execute(uint64_t max_cycles);
+
+    /**
+     * @brief Executes one instruction in the interpreter, stopping at
+     * breakpoints and watchpoints the way execute() does: in front of a
+     * breakpoint whose condition holds, unless the last call stopped there.
+     *
+     * @return 1, or 0 if a breakpoint, watchpoint or fault stopped it.
+     */
+    uint64_t step();
+
+    /**
+     * @brief Breakpoints, one bit per address. While any is set, execute()
+     * checks the bit of every PC and stops in front of a set one; the next
+     * execute() from that PC runs the instruction instead of stopping
+     * again. With none set, execution pays nothing for them.
+     */
+    void setBreakpoint(uint16_t address, bool enabled);
+    bool hasBreakpoint(uint16_t address) const;
+    void clearBreakpoints();
+
+    /**
+     * @brief A breakpoint that only stops execute() while `condition`
+     * holds.
+     */
+    void setBreakpoint(uint16_t address, const Condition& condition);
+
+    /**
+     * @brief Watchpoints on the bytes first to last for one kind of access,
+     * kept as a flag table with a bit per address and kind. A read or write
+     * by an instruction stops execute() after that instruction; an execute
+     * watchpoint stops it in front of the instruction like a breakpoint.
+     * With none set, execution pays nothing for them.
+     */
+    void setWatchpoint(uint16_t first, uint16_t last, MemoryFault::Kind kind,
+                       bool enabled);
+    void clearWatchpoints();
+
+    /**
+     * @brief The watched access that stopped execute(), nullptr if there
+     * is none. The next execute() clears it.
+     */
+    const WatchHit* getWatchHit() const;
+    void clearWatchHit();
+
+    /**
+     * @brief True if the last execute() stopped at a breakpoint.
+     */
+    bool isAtBreakpoint() const;
+
+    /**
+     * @brief True while an FX0A waits for a key to be pressed and released.
+     * Nothing but input changes the machine then, apart from its timers.
+     */
+    bool isWaitingForKey() const;
+
+    /**
+     * @brief Reseeds the built-in CXNN generator. Machines start seeded from
+     * std::random_device; seed them explicitly for reproducible runs.
+     */
+    void seedRandom(uint64_t seed);
+
+    /**
+     * @brief Replaces the built-in generator as the source of CXNN values.
+     * Pass nullptr to go back to the built-in one.
+     */
+    void setRandomSource(std::unique_ptr<RandomSource> source);
+
+    /**
+     * @brief Instructions executed since the machine was created.
+     */
+    uint64_t getInstructionCount() const;
+
+    /**
+     * @brief Starts writing a binary instruction trace to `path` (see
+     * trace.hpp, decode it with chip8-tracedump). While tracing, every
+     * engine runs through the interpreter.
+     *
+     * @return False if the file cannot be created or the build has tracing
+     * compiled out (configure with -DCHIP8_TRACE=ON).
+     */
+    bool startTrace(const std::string& path, bool capture_registers);
+    void stopTrace();
+
+    /**
+     * @brief Starts an input movie (see movie.hpp) at the current state:
+     * from now on the keys of every frame run by run() or runFrames() are
+     * written to `path`. Rewinding is suspended until stopMovie().
+     */
+    bool startRecording(const std::string& path);
+
+    /**
+     * @brief Restores the state, memory policy, quirk profile and speed a
+     * movie was recorded with, then feeds its keys to every frame instead
+     * of the host keyboard. With the RNG state restored too, the replay goes
+     * through exactly the recorded frames.
+     *
+     * @return False, leaving the machine untouched, if the movie cannot
+     * be read.
+     */
+    bool startReplay(const std::string& path);
+
+    /**
+     * @brief Ends recording (finishing the file) or replay.
+     */
+    void stopMovie();
+
+    /**
+     * @brief True until the replayed movie runs out of frames; the keys
+     * are then back under host control.
+     */
+    bool isReplaying() const;
+
+    /**
+     * @brief Runs `frames` emulated frames without any pacing: each frame
+     * executes `cycles_per_frame` instructions, then ticks the timers once.
+     *
+     * @return The number of instructions executed.
+     */
+    uint64_t runFrames(uint64_t frames, uint32_t cycles_per_frame);
+
+    /**
+     * @brief FNV-1a hash over memory, registers, stack, RNG state and
+     * framebuffer.
+     * Two machines with the same hash are in the same emulated state.
+     */
+    uint64_t stateHash() const;
+
+    /**
+     * @brief Snapshots the whole machine (memory, registers, stack, timers,
+     * framebuffer, keys and RNG) into a SaveState blob.
+     */
+    std::vector<uint8_t> saveState() const;
+
+    /**
+     * @brief Restores a blob from saveState(). The framebuffer and keys are
+     * only restored if both the blob and this machine have them.
+     *
+     * @return False, leaving the machine untouched, if the blob is not a
+     * save state of this version.
+     */
+    bool loadState(const std::vector<uint8_t>& blob);
+
+    bool saveStateToFile(const std::string& path) const;
+    bool loadStateFromFile(const std::string& path);
+
+    /**
+     * @brief Keeps up to about `bytes` of rewind history (0 turns rewinding
+     * off and drops the history). run() records one snapshot per frame.
+     */
+    void setRewindCapacity(size_t bytes);
+
+    /**
+     * @brief Appends the current state to the rewind history.
+     */
+    void recordRewind();
+
+    /**
+     * @brief Returns to the previous snapshot in the rewind history.
+     *
+     * @return False if there is no earlier snapshot, or while a movie is
+     * recorded or replayed: a movie runs every frame forward from its start
+     * state, so going back would make the replay diverge.
+     */
+    bool rewind();
+
+    /**
+     * @brief The rewind history, nullptr while rewinding is off.
+     */
+    const RewindBuffer* getRewindBuffer() const;
+
+    /**
+     * @brief Plays the sound timer through an SDL audio device opened with
+     * `config`, replacing the current one. NORMAL mode starts with the
+     * defaults; the other modes can use this to play to SDL's dummy or
+     * disk driver.
+     *
+     * @return False, leaving the machine silent, if no device could be
+     * opened.
+     */
+    bool setAudio(const AudioConfig& config);
+    void closeAudio();
+
+    /**
+     * @brief The samples queued for the audio device, nullptr while silent.
+     */
+    const AudioStream* getAudio() const;
+
+    /**
+     * @brief The emulated display, nullptr in TEST mode.
+     */
+    const Framebuffer* getDisplay() const;
+
+    /**
+     * @brief The whole emulated machine. Copying it clones the machine.
+     */
+    const MachineState& getState() const;
+
+    /**
+     * @brief Replaces the whole emulated machine, e.g. with a copy taken
+     * from getState() of this or another CPU.
+     */
+    void setState(const MachineState& machine);
+
+    // Timers tick and the screen is presented once per frame.
+    static constexpr uint32_t FRAME_RATE = 60;
+    // Minutes of typical play at one snapshot per frame.
+    static constexpr size_t DEFAULT_REWIND_BYTES = 8 << 20;
+    // Matches the original 500 Hz CPU clock with 60 Hz timers.
+    static constexpr uint32_t DEFAULT_CYCLES_PER_FRAME = 8;
+
 private:
+    struct ForkTag {};
+    Chip8CPU(const Chip8CPU& parent, ForkTag);
+
+    // One instruction with the current memory policy and quirk profile.
     void cycle();
+    template <class Core>
+    void cycle_with();
+    template <class Core>
+    uint64_t execute_with(uint64_t max_cycles);
+    // The interpreter with a breakpoint check in front of every instruction.
+    template <class Core>
+    uint64_t execute_checked(uint64_t max_cycles);
+    // Whether execute_checked() stops in front of the instruction at `pc`.
+    bool stops_at(uint16_t pc);
+    // Records the first watched byte in an access, at the addresses Core
+    // resolves it to, if any.
+    template <class Core>
+    void watch_access(uint32_t address, size_t length, MemoryFault::Kind kind,
+                      uint16_t pc);
+    template <class Core>
+    uint64_t execute_threaded(uint64_t max_cycles);
+    // Replaces all of memory with the ROM's boot image from RomCache.
     bool loadROM(const std::string& filename);
     void update_timers();
     bool handle_input();
     void render();
+    // Records or replays the keys of the frame about to run.
+    void movie_frame();
+    // run()'s emulation thread.
+    struct HostLink;
+    void emulate(HostLink& link);
+
+    // Copy the registers and the memory_extent bytes of memory in use.
+    void captureState(SaveState& saved) const;
+    bool restoreState(const SaveState& saved);
+
+    // Zero-fills memory up to `size` before it comes into use.
+    void extend_memory(size_t size);
+    // Bytes of `state` up to the end of memory_extent.
+    size_t state_bytes() const;
+
+    // Writes to emulated memory that keep decoded and translated code in
+    // sync; anything past the end of memory is dropped.
+    void writeMemory(uint16_t address, const uint8_t* data, size_t length);
+    void writeByte(uint16_t address, uint8_t value);
+    void notifyWrite(uint16_t address, size_t length);
+
+    // Memory accesses of the instructions under an access policy.
+    // checkAccess() raises the fault for TRAPPING and is free otherwise.
+    template <class Core>
+    bool checkAccess(uint32_t address, size_t length, MemoryFault::Kind kind,
+                     uint16_t pc);
+    template <class Core>
+    void storeBytes(uint32_t address, const uint8_t* data, size_t length);
+
+    template <class Core>
+    static DecodedOp decode(uint16_t opcode);
+    template <class Core>
+    uint16_t fetch(uint16_t address);
+    template <class Core>
+    const DecodedOp* lookup(uint16_t pc, DecodedOp& uncached);
+
+    // Instruction handlers, see DecodedOp for the PC convention.
+    static void op_NOP(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00E0(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00EE(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_1NNN(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_2NNN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_3XNN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_4XNN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_5XY0(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_6XNN(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_7XNN(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_8XY0(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_8XY1(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_8XY2(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_8XY3(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_8XY4(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_8XY5(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_8XY6(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_8XY7(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_8XYE(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_9XY0(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_ANNN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_BNNN(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_CXNN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_DXYN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_EX9E(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_EXA1(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX07(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX0A(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX15(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX18(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX1E(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX29(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_FX33(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_FX55(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_FX65(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00CN(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00FB(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00FC(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00FD(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00FE(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00FF(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX30(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX75(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX85(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_00DN(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_5XY2(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_5XY3(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_F000(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FN01(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static void op_F002(Chip8CPU& cpu, const DecodedOp& op);
+    static void op_FX3A(Chip8CPU& cpu, const DecodedOp& op);
+    template <class Core>
+    static const DecodedOp::Handler
+        handlers[static_cast<size_t>(OpKind::COUNT)];
+
+    MachineState state;
+    // Leading bytes of state.memory in use: the profile's address space and
+    // anything written past it. The rest is never read, so copies, snapshots
+    // and forks skip it; it is unspecified in a fork.
+    size_t memory_extent = Memory::CLASSIC_SIZE;
 
-    std::unique_ptr<Memory> mem;
-    std::unique_ptr<Register> reg;
-    std::unique_ptr<Chip8Display> display;
-    std::unique_ptr<Chip8Keypad> keypad;
-    std::unique_ptr<Stack> stack;
-    uint16_t stack_array[16];  // Stack storage array
+    // Host side: everything below is derived from or presents `state`.
+    Chip8Mode mode;
+    std::unique_ptr<Chip8Display> display;  // NORMAL mode only
+    std::unique_ptr<Chip8Keypad> keypad;    // NORMAL mode only
+    std::unique_ptr<Chip8Audio> audio;      // NORMAL mode or setAudio()
+    std::vector<MemoryObserver*> observers;  // Besides decode_cache
+    std::shared_ptr<DecodeCache> decode_cache;  // Shared with forks
+    std::unique_ptr<JitEngine> jit;  // Created on first use
+    Chip8Engine engine = Chip8Engine::INTERPRETER;
+    MemoryPolicy memory_policy = MemoryPolicy::CHECKED;
+    QuirkProfile quirk_profile = QuirkProfile::DEFAULT;
+    MemoryFault fault;
+    bool faulted = false;
+    std::unique_ptr<uint64_t[]> breakpoints;  // Memory::MEM_SIZE bits
+    size_t breakpoint_count = 0;
+    std::unordered_map<uint16_t, Condition> breakpoint_conditions;
+    bool breakpoint_hit = false;
+    std::unique_ptr<uint8_t[]> watch_flags;  // 1 << Kind per address
+    size_t watch_count = 0;                  // Bits set in watch_flags
+    WatchHit watch_hit;
+    bool watch_stopped = false;
+    bool stopped_before = false;  // In front of stop_pc, by a breakpoint
+    uint16_t stop_pc = 0;         // or an execute watchpoint
+    uint32_t cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
+    bool turbo = false;
+    RunStats stats;
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+    std::unique_ptr<SaveState> rewind_scratch;  // With rewind_buffer
+    std::unique_ptr<RandomSource> random_source;  // Overrides state.rng
+    std::unique_ptr<MovieRecorder> recorder;
+    std::unique_ptr<MoviePlayer> player;
+    uint64_t instructions = 0;
+#ifdef CHIP8_TRACE
+    std::unique_ptr<Tracer> tracer;
+#endif
 
     friend class Chip8TestAccess;
 };
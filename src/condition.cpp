@@ -0,0 +1,275 @@
+#include "condition.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace CHIP8 {
+
+namespace {
+
+using Op = Condition::Op;
+
+// Recursive descent over the text, emitting postfix code as it goes.
+class Parser {
+public:
+    Parser(const std::string& text,
+           std::vector<Condition::Instruction>& code)
+        : text(text), code(code) {
+    }
+
+    bool parse(std::string& error) {
+        parseOr();
+        skipSpace();
+        if (message.empty() && pos < text.size()) {
+            fail("unexpected '" + text.substr(pos) + "'");
+        }
+        if (message.empty() && max_depth > Condition::MAX_DEPTH) {
+            fail("expression too deep");
+        }
+        error = message;
+        return message.empty();
+    }
+
+private:
+    void parseOr() {
+        parseAnd();
+        while (accept("||")) {
+            parseAnd();
+            emit(Op::OR);
+        }
+    }
+
+    void parseAnd() {
+        parseComparison();
+        while (accept("&&")) {
+            parseComparison();
+            emit(Op::AND);
+        }
+    }
+
+    void parseComparison() {
+        parseSum();
+        static const struct {
+            const char* token;
+            Op op;
+        } comparisons[] = {
+            {"==", Op::EQ}, {"!=", Op::NE}, {"<=", Op::LE},
+            {">=", Op::GE}, {"<", Op::LT},  {">", Op::GT},
+        };
+        for (const auto& comparison : comparisons) {
+            if (accept(comparison.token)) {
+                parseSum();
+                emit(comparison.op);
+                return;
+            }
+        }
+    }
+
+    void parseSum() {
+        parseUnary();
+        while (true) {
+            Op op;
+            if (accept("+")) {
+                op = Op::ADD;
+            } else if (accept("-")) {
+                op = Op::SUB;
+            } else if (peek("&&") || !accept("&")) {
+                return;
+            } else {
+                op = Op::AND_BITS;
+            }
+            parseUnary();
+            emit(op);
+        }
+    }
+
+    void parseUnary() {
+        if (peek("!=")) {
+            fail("missing operand before '!='");
+        } else if (accept("!")) {
+            parseUnary();
+            emit(Op::NOT);
+        } else {
+            parsePrimary();
+        }
+    }
+
+    void parsePrimary() {
+        skipSpace();
+        if (!message.empty()) {
+            return;
+        }
+        if (accept("(")) {
+            parseOr();
+            expect(")");
+        } else if (accept("[")) {
+            parseOr();
+            expect("]");
+            emit(Op::MEMORY);
+        } else if (pos < text.size() && std::isdigit(uchar(text[pos]))) {
+            parseNumber();
+        } else if (pos < text.size() && std::isalpha(uchar(text[pos]))) {
+            size_t start = pos;
+            while (pos < text.size() && std::isalnum(uchar(text[pos]))) {
+                ++pos;
+            }
+            parseRegister(text.substr(start, pos - start));
+        } else {
+            fail(pos < text.size() ? "unexpected '" + text.substr(pos) + "'"
+                                   : "missing operand");
+        }
+    }
+
+    // Decimal, or hex after 0x; a leading 0 does not mean octal.
+    void parseNumber() {
+        bool hex = (text.compare(pos, 2, "0x") == 0 ||
+                    text.compare(pos, 2, "0X") == 0);
+        const char* start = text.c_str() + pos + (hex ? 2 : 0);
+        if (hex && !std::isxdigit(uchar(*start))) {
+            fail("missing hex digits after '0x'");
+            return;
+        }
+        char* end;
+        unsigned long value = std::strtoul(start, &end, hex ? 16 : 10);
+        pos = end - text.c_str();
+        emit(Op::CONST, uint32_t(value));
+    }
+
+    void parseRegister(std::string name) {
+        for (char& c : name) {
+            c = char(std::toupper(uchar(c)));
+        }
+        static const struct {
+            const char* name;
+            Op op;
+        } registers[] = {
+            {"I", Op::I},   {"PC", Op::PC}, {"SP", Op::SP},
+            {"DT", Op::DT}, {"ST", Op::ST},
+        };
+        for (const auto& reg : registers) {
+            if (name == reg.name) {
+                emit(reg.op);
+                return;
+            }
+        }
+        if (name.size() == 2 && name[0] == 'V' &&
+            std::isxdigit(uchar(name[1]))) {
+            emit(Op::V, uint32_t(std::strtoul(name.c_str() + 1, nullptr, 16)));
+            return;
+        }
+        fail("unknown register '" + name + "'");
+    }
+
+    static unsigned char uchar(char c) {
+        return static_cast<unsigned char>(c);
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(uchar(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool peek(const char* token) {
+        skipSpace();
+        return text.compare(pos, std::char_traits<char>::length(token),
+                            token) == 0;
+    }
+
+    bool accept(const char* token) {
+        if (!message.empty() || !peek(token)) {
+            return false;
+        }
+        pos += std::char_traits<char>::length(token);
+        return true;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) {
+            fail(std::string("expected '") + token + "'");
+        }
+    }
+
+    void emit(Op op, uint32_t arg = 0) {
+        if (!message.empty()) {
+            return;
+        }
+        code.push_back({op, arg});
+        // Operands push one value, binary operators pop two for one.
+        if (op <= Op::MEMORY) {
+            depth += op != Op::MEMORY;
+        } else if (op != Op::NOT) {
+            --depth;
+        }
+        max_depth = std::max(max_depth, depth);
+    }
+
+    void fail(const std::string& what) {
+        if (message.empty()) {
+            message = what;
+        }
+    }
+
+    const std::string& text;
+    std::vector<Condition::Instruction>& code;
+    size_t pos = 0;
+    size_t depth = 0;
+    size_t max_depth = 0;
+    std::string message;
+};
+
+}  // namespace
+
+bool Condition::compile(const std::string& text, Condition& condition,
+                        std::string& error) {
+    std::vector<Instruction> code;
+    if (!Parser(text, code).parse(error)) {
+        return false;
+    }
+    condition.code = std::move(code);
+    return true;
+}
+
+bool Condition::evaluate(const MachineState& state) const {
+    uint32_t stack[MAX_DEPTH];
+    size_t top = 0;  // Number of values on the stack
+    for (const Instruction& in : code) {
+        switch (in.op) {
+            case Op::CONST: stack[top++] = in.arg; break;
+            case Op::V: stack[top++] = state.reg.V[in.arg]; break;
+            case Op::I: stack[top++] = state.reg.I; break;
+            case Op::PC: stack[top++] = state.reg.PC; break;
+            case Op::SP: stack[top++] = state.reg.SP; break;
+            case Op::DT: stack[top++] = state.reg.delay_timer; break;
+            case Op::ST: stack[top++] = state.reg.sound_timer; break;
+            case Op::MEMORY:
+                stack[top - 1] =
+                    state.memory.bytes[stack[top - 1] % Memory::MEM_SIZE];
+                break;
+            case Op::NOT: stack[top - 1] = !stack[top - 1]; break;
+            default: {
+                uint32_t b = stack[--top];
+                uint32_t& a = stack[top - 1];
+                switch (in.op) {
+                    case Op::ADD: a = a + b; break;
+                    case Op::SUB: a = a - b; break;
+                    case Op::AND_BITS: a = a & b; break;
+                    case Op::EQ: a = a == b; break;
+                    case Op::NE: a = a != b; break;
+                    case Op::LT: a = a < b; break;
+                    case Op::LE: a = a <= b; break;
+                    case Op::GT: a = a > b; break;
+                    case Op::GE: a = a >= b; break;
+                    case Op::AND: a = a && b; break;
+                    case Op::OR: a = a || b; break;
+                    default: break;
+                }
+            }
+        }
+    }
+    // An empty condition is always true.
+    return top == 0 || stack[0] != 0;
+}
+
+}  // namespace CHIP8
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "machine_state.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief A debugger condition such as `V3 == 0x10 && I > 0x300`, compiled
+ * once into stack bytecode and evaluated against a MachineState.
+ *
+ * Operands are the registers V0-VF, I, PC, SP, DT and ST, numbers in
+ * decimal or 0x hex, and `[expr]`, the memory byte at an address. Operators
+ * from loosest to tightest: `||`, `&&`, the comparisons `== != < <= > >=`,
+ * then `+ - &` (left to right) and unary `!`; parentheses group. Values
+ * are unsigned 32-bit and any non-zero result counts as true.
+ */
+class Condition {
+public:
+    /**
+     * @return False, with a message in `error`, if `text` does not parse.
+     */
+    static bool compile(const std::string& text, Condition& condition,
+                        std::string& error);
+
+    bool evaluate(const MachineState& state) const;
+
+    // Deepest operand stack any condition may need.
+    static const size_t MAX_DEPTH = 16;
+
+    enum class Op : uint8_t {
+        CONST, V, I, PC, SP, DT, ST, MEMORY,
+        NOT, ADD, SUB, AND_BITS,
+        EQ, NE, LT, LE, GT, GE, AND, OR,
+    };
+
+    struct Instruction {
+        Op op;
+        uint32_t arg;  // CONST value or V index
+    };
+
+private:
+    std::vector<Instruction> code;
+};
+
+}  // namespace CHIP8
@@ -1,5 +1,6 @@
 #include "debugger.hpp"
 #include "test_access.hpp"
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <thread>
@@ -7,22 +8,45 @@
 namespace CHIP8 {
 
 Debugger::Debugger(Chip8CPU& cpu) : cpu(cpu) {
+    // Every instruction run from the debugger becomes one rewind snapshot.
+    if (!cpu.getRewindBuffer()) {
+        cpu.setRewindCapacity(Chip8CPU::DEFAULT_REWIND_BYTES);
+    }
+    cpu.recordRewind();
 }
 
 void Debugger::addBreakpoint(uint16_t addr) {
-    breakpoints.insert(addr);
+    cpu.setBreakpoint(addr, true);
+}
+
+void Debugger::addBreakpoint(uint16_t addr, const Condition& condition) {
+    cpu.setBreakpoint(addr, condition);
 }
 
 void Debugger::removeBreakpoint(uint16_t addr) {
-    breakpoints.erase(addr);
+    cpu.setBreakpoint(addr, false);
 }
 
 void Debugger::clearBreakpoints() {
-    breakpoints.clear();
+    cpu.clearBreakpoints();
 }
 
 bool Debugger::hasBreakpoint(uint16_t addr) const {
-    return breakpoints.count(addr);
+    return cpu.hasBreakpoint(addr);
+}
+
+void Debugger::addWatchpoint(uint16_t first, uint16_t last,
+                             MemoryFault::Kind kind) {
+    cpu.setWatchpoint(first, last, kind, true);
+}
+
+void Debugger::removeWatchpoint(uint16_t first, uint16_t last,
+                                MemoryFault::Kind kind) {
+    cpu.setWatchpoint(first, last, kind, false);
+}
+
+void Debugger::clearWatchpoints() {
+    cpu.clearWatchpoints();
 }
 
 bool Debugger::isWindowClosed() {
@@ -33,44 +57,104 @@ bool Debugger::isWindowClosed() {
 }
 
 void Debugger::step() {
-    uint16_t current_pc = CHIP8::Chip8TestAccess::getPC(cpu);
-    if (breakpoints.count(current_pc)) {
-        std::cout << "Breakpoint hit at 0x" << std::hex << current_pc << std::endl;
-        return; 
-    }
-    
     if (!CHIP8::Chip8TestAccess::handle_input(cpu)) {
         std::cout << "SDL window closed during step" << std::endl;
         return;
     }
     
-    CHIP8::Chip8TestAccess::cycle(cpu);
+    // As in continueExecution(), a breakpoint stops a step in front of it
+    // only while its condition holds, and the next step runs past it.
+    uint64_t executed = cpu.step();
+    if (reportFault()) {
+        return;
+    }
+    if (cpu.isAtBreakpoint()) {
+        std::cout << "Breakpoint hit at 0x" << std::hex
+                  << CHIP8::Chip8TestAccess::getPC(cpu) << std::endl;
+        return;
+    }
+    if (reportWatch() && executed == 0) {
+        return;
+    }
     CHIP8::Chip8TestAccess::update_timers(cpu);
+    cpu.recordRewind();
     CHIP8::Chip8TestAccess::render(cpu);
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
+bool Debugger::stepBack() {
+    if (!cpu.rewind()) {
+        return false;
+    }
+    CHIP8::Chip8TestAccess::render(cpu);
+    return true;
+}
+
 void Debugger::continueExecution() {
+    using clock = std::chrono::steady_clock;
+    const auto frame_duration =
+        std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(1.0 / Chip8CPU::FRAME_RATE));
+    // Frames as run() paces them; the CPU checks the breakpoints itself.
+    auto deadline = clock::now();
     while (true) {
         if (!CHIP8::Chip8TestAccess::handle_input(cpu)) {
             std::cout << "SDL window closed during continue" << std::endl;
             break;
         }
-        
-        uint16_t current_pc = CHIP8::Chip8TestAccess::getPC(cpu);
-        if (breakpoints.count(current_pc)) {
-            std::cout << "Breakpoint hit at 0x" << std::hex << current_pc << std::endl;
-            break; 
+        cpu.execute(cpu.getCyclesPerFrame());
+        if (reportFault()) {
+            break;
+        }
+        if (cpu.isAtBreakpoint()) {
+            cpu.recordRewind();
+            CHIP8::Chip8TestAccess::render(cpu);
+            std::cout << "Breakpoint hit at 0x" << std::hex
+                      << CHIP8::Chip8TestAccess::getPC(cpu) << std::endl;
+            break;
+        }
+        if (cpu.getWatchHit()) {
+            cpu.recordRewind();
+            CHIP8::Chip8TestAccess::render(cpu);
+            reportWatch();
+            break;
         }
-        CHIP8::Chip8TestAccess::cycle(cpu);
         CHIP8::Chip8TestAccess::update_timers(cpu);
+        cpu.recordRewind();
         CHIP8::Chip8TestAccess::render(cpu);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        deadline += frame_duration;
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+bool Debugger::reportFault() {
+    const MemoryFault* fault = cpu.getMemoryFault();
+    if (!fault) {
+        return false;
+    }
+    static const char* const kinds[] = {"read", "write", "execute"};
+    std::cout << "Memory fault: " << kinds[fault->kind] << " at 0x"
+              << std::hex << fault->address << " by the instruction at 0x"
+              << fault->pc << std::dec << std::endl;
+    cpu.clearMemoryFault();
+    return true;
+}
+
+bool Debugger::reportWatch() {
+    const WatchHit* hit = cpu.getWatchHit();
+    if (!hit) {
+        return false;
     }
+    static const char* const kinds[] = {"read", "write", "execute"};
+    std::cout << "Watchpoint: " << kinds[hit->kind] << " at 0x" << std::hex
+              << hit->address << " by the instruction at 0x" << hit->pc
+              << std::dec << std::endl;
+    cpu.clearWatchHit();
+    return true;
 }
 
 bool Debugger::isAtBreakpoint() const {
-    return breakpoints.count(CHIP8::Chip8TestAccess::getPC(cpu));
+    return cpu.isAtBreakpoint();
 }
 
 std::unique_ptr<Register> Debugger::inspectRegister() {
@@ -2,7 +2,6 @@
 #include <iostream>
 #include <string>
 #include <memory>
-#include <unordered_set>
 
 #include "chip8.hpp"
 #include "register.hpp"
@@ -15,11 +14,31 @@ public:
     ~Debugger() = default;
     
     void addBreakpoint(uint16_t addr);
+    void addBreakpoint(uint16_t addr, const Condition& condition);
     void removeBreakpoint(uint16_t addr);
     void clearBreakpoints();
     bool hasBreakpoint(uint16_t addr) const;
+
+    void addWatchpoint(uint16_t first, uint16_t last, MemoryFault::Kind kind);
+    void removeWatchpoint(uint16_t first, uint16_t last,
+                          MemoryFault::Kind kind);
+    void clearWatchpoints();
     
     void step();
+
+    /**
+     * @brief Undoes the last step, or the last frame of a continue, from
+     * the CPU's rewind history.
+     *
+     * @return False if the history holds nothing earlier.
+     */
+    bool stepBack();
+
+    /**
+     * @brief Runs at normal speed, input and rendering once per frame,
+     * until a breakpoint, watchpoint or fault stops the CPU or the window
+     * is closed.
+     */
     void continueExecution();
     void setStepping(bool enable);
     bool isAtBreakpoint() const;
@@ -30,8 +49,12 @@ public:
     bool isWindowClosed();
 
 private:
+    // Prints and clears a fault raised under MemoryPolicy::TRAPPING.
+    bool reportFault();
+    // Prints and clears the access that hit a watchpoint.
+    bool reportWatch();
+
     Chip8CPU& cpu;
-    std::unordered_set<uint16_t> breakpoints;
     bool stepping = false;
 };
 
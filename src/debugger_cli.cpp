@@ -69,6 +69,8 @@ bool DebuggerCLI::parseCommand(const std::string& input) {
     std::string command = args[0];
     if (command == "s" || command == "step") {
         handleStep(args);
+    } else if (command == "bs" || command == "back") {
+        handleBack(args);
     } else if (command == "c" || command == "continue") {
         handleContinue(args);
     } else if (command == "b" || command == "break") {
@@ -77,6 +79,10 @@ bool DebuggerCLI::parseCommand(const std::string& input) {
         handleDeleteBreakpoint(args);
     } else if (command == "clear") {
         handleClearBreakpoints(args);
+    } else if (command == "w" || command == "watch") {
+        handleWatchpoint(args);
+    } else if (command == "unwatch") {
+        handleDeleteWatchpoint(args);
     } else if (command == "r" || command == "registers") {
         handleRegisters(args);
     } else if (command == "m" || command == "memory") {
@@ -116,6 +122,27 @@ void DebuggerCLI::handleStep(const std::vector<std::string>& args) {
     }
 }
 
+void DebuggerCLI::handleBack(const std::vector<std::string>& args) {
+    int steps = 1;
+    if (args.size() > 1) {
+        try {
+            steps = std::stoi(args[1]);
+        } catch (...) {
+            std::cout << "Invalid step count: " << args[1] << std::endl;
+            return;
+        }
+    }
+
+    for (int i = 0; i < steps; i++) {
+        if (!debugger.stepBack()) {
+            std::cout << "No earlier state in the rewind history" << std::endl;
+            break;
+        }
+    }
+    auto regs = debugger.inspectRegister();
+    std::cout << "Back at PC=0x" << std::hex << regs->PC << std::endl;
+}
+
 void DebuggerCLI::handleContinue(const std::vector<std::string>& args) {
     std::cout << "Continuing execution..." << std::endl;
     debugger.continueExecution();
@@ -124,17 +151,35 @@ void DebuggerCLI::handleContinue(const std::vector<std::string>& args) {
 }
 
 void DebuggerCLI::handleBreakpoint(const std::vector<std::string>& args) {
-    if (args.size() < 2) {
-        std::cout << "Usage: break <address>" << std::endl;
+    if (args.size() < 2 || (args.size() > 2 && args[2] != "if")) {
+        std::cout << "Usage: break <address> [if <condition>]" << std::endl;
         return;
     }
+    uint16_t addr;
     try {
-        uint16_t addr = std::stoul(args[1], nullptr, 16);
-        debugger.addBreakpoint(addr);
-        std::cout << "Breakpoint set at 0x" << std::hex << addr << std::endl;
+        addr = std::stoul(args[1], nullptr, 16);
     } catch (...) {
         std::cout << "Invalid address: " << args[1] << std::endl;
+        return;
+    }
+    if (args.size() == 2) {
+        debugger.addBreakpoint(addr);
+        std::cout << "Breakpoint set at 0x" << std::hex << addr << std::endl;
+        return;
     }
+    std::string text;
+    for (size_t i = 3; i < args.size(); i++) {
+        text += args[i] + " ";
+    }
+    Condition condition;
+    std::string error;
+    if (!Condition::compile(text, condition, error)) {
+        std::cout << "Invalid condition: " << error << std::endl;
+        return;
+    }
+    debugger.addBreakpoint(addr, condition);
+    std::cout << "Breakpoint set at 0x" << std::hex << addr << " if " << text
+              << std::endl;
 }
 
 void DebuggerCLI::handleDeleteBreakpoint(const std::vector<std::string>& args) {
@@ -157,6 +202,73 @@ void DebuggerCLI::handleClearBreakpoints(const std::vector<std::string>& args) {
     std::cout << "All breakpoints cleared" << std::endl;
 }
 
+// Parses `<r|w|rw|x> <first> [last]` into the access kinds and the range.
+static bool parseWatch(const std::vector<std::string>& args,
+                       std::vector<MemoryFault::Kind>& kinds,
+                       uint16_t& first, uint16_t& last) {
+    if (args.size() < 3) {
+        return false;
+    }
+    if (args[1] == "r") {
+        kinds = {MemoryFault::READ};
+    } else if (args[1] == "w") {
+        kinds = {MemoryFault::WRITE};
+    } else if (args[1] == "rw") {
+        kinds = {MemoryFault::READ, MemoryFault::WRITE};
+    } else if (args[1] == "x") {
+        kinds = {MemoryFault::EXECUTE};
+    } else {
+        return false;
+    }
+    unsigned long start, end;
+    try {
+        start = std::stoul(args[2], nullptr, 16);
+        end = args.size() > 3 ? std::stoul(args[3], nullptr, 16) : start;
+    } catch (...) {
+        return false;
+    }
+    if (end > 0xFFFF || end < start) {
+        return false;
+    }
+    first = uint16_t(start);
+    last = uint16_t(end);
+    return true;
+}
+
+void DebuggerCLI::handleWatchpoint(const std::vector<std::string>& args) {
+    std::vector<MemoryFault::Kind> kinds;
+    uint16_t first, last;
+    if (!parseWatch(args, kinds, first, last)) {
+        std::cout << "Usage: watch <r|w|rw|x> <first> [last]" << std::endl;
+        return;
+    }
+    for (MemoryFault::Kind kind : kinds) {
+        debugger.addWatchpoint(first, last, kind);
+    }
+    std::cout << "Watchpoint set on 0x" << std::hex << first << "-0x" << last
+              << std::endl;
+}
+
+void DebuggerCLI::handleDeleteWatchpoint(
+    const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        debugger.clearWatchpoints();
+        std::cout << "All watchpoints cleared" << std::endl;
+        return;
+    }
+    std::vector<MemoryFault::Kind> kinds;
+    uint16_t first, last;
+    if (!parseWatch(args, kinds, first, last)) {
+        std::cout << "Usage: unwatch [<r|w|rw|x> <first> [last]]" << std::endl;
+        return;
+    }
+    for (MemoryFault::Kind kind : kinds) {
+        debugger.removeWatchpoint(first, last, kind);
+    }
+    std::cout << "Watchpoint removed from 0x" << std::hex << first << "-0x"
+              << last << std::endl;
+}
+
 void DebuggerCLI::handleRegisters(const std::vector<std::string>& args) {
     auto regs = debugger.inspectRegister();
     
@@ -200,10 +312,14 @@ void DebuggerCLI::handleQuit(const std::vector<std::string>& args) {
 void DebuggerCLI::handleHelp(const std::vector<std::string>& args) {
     std::cout << "Available commands:" << std::endl;
     std::cout << "  s, step [n]        - Execute n instructions (default: 1)" << std::endl;
+    std::cout << "  bs, back [n]       - Undo n steps (default: 1)" << std::endl;
     std::cout << "  c, continue        - Continue execution until breakpoint" << std::endl;
     std::cout << "  b, break <addr>     - Set breakpoint at address" << std::endl;
+    std::cout << "    break <addr> if <cond> - Stop only while cond holds, e.g. V3 == 0x10 && I > 0x300" << std::endl;
     std::cout << "  d, delete <addr>    - Remove breakpoint at address" << std::endl;
     std::cout << "  clear               - Clear all breakpoints" << std::endl;
+    std::cout << "  w, watch <r|w|rw|x> <first> [last] - Stop on access to an address range" << std::endl;
+    std::cout << "  unwatch [<kind> <first> [last]]    - Remove watchpoints (all without arguments)" << std::endl;
     std::cout << "  r, registers        - Show all registers" << std::endl;
     std::cout << "  m, memory <s> <e>  - Dump memory from start to end address" << std::endl;
     std::cout << "  q, quit             - Exit debugger" << std::endl;
@@ -22,10 +22,13 @@ private:
     bool parseCommand(const std::string& input);
     
     void handleStep(const std::vector<std::string>& args);
+    void handleBack(const std::vector<std::string>& args);
     void handleContinue(const std::vector<std::string>& args);
     void handleBreakpoint(const std::vector<std::string>& args);
     void handleDeleteBreakpoint(const std::vector<std::string>& args);
     void handleClearBreakpoints(const std::vector<std::string>& args);
+    void handleWatchpoint(const std::vector<std::string>& args);
+    void handleDeleteWatchpoint(const std::vector<std::string>& args);
     void handleRegisters(const std::vector<std::string>& args);
     void handleMemory(const std::vector<std::string>& args);
     void handleQuit(const std::vector<std::string>& args);
@@ -0,0 +1,51 @@
+#include "decode_cache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace CHIP8 {
+
+static DecodedOp* allocateOps() {
+    void* ops = calloc(DecodeCache::SIZE, sizeof(DecodedOp));
+    if (!ops) {
+        throw std::bad_alloc();
+    }
+    return static_cast<DecodedOp*>(ops);
+}
+
+void DecodeCache::Free::operator()(DecodedOp* ops) const {
+    free(ops);
+}
+
+DecodeCache::DecodeCache() : ops(allocateOps()) {
+}
+
+DecodeCache::DecodeCache(const DecodeCache& other)
+    : ops(allocateOps()), used(other.used) {
+    memcpy(ops.get(), other.ops.get(), used * sizeof(DecodedOp));
+}
+
+void DecodeCache::invalidate(uint16_t address, size_t length) {
+    // The instruction starting one byte earlier also covers `address`.
+    size_t first = address > 0 ? address - 1 : 0;
+    if (length == 0 || first >= used) {
+        return;
+    }
+    size_t last = std::min<size_t>(address + length, used);
+    for (size_t i = first; i < last; ++i) {
+        ops[i].handler = nullptr;
+    }
+}
+
+void DecodeCache::invalidateAll() {
+    memset(ops.get(), 0, used * sizeof(DecodedOp));
+    used = 0;
+}
+
+void DecodeCache::onMemoryWrite(uint16_t address, size_t length) {
+    invalidate(address, length);
+}
+
+}  // namespace CHIP8
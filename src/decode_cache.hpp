@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "memory.hpp"
+
+namespace CHIP8 {
+class Chip8CPU;
+
+/**
+ * @brief Instruction classes, one per handler. Used as the dispatch index by
+ * the threaded interpreter.
+ */
+enum class OpKind : uint8_t {
+    NOP,       // Unknown or ignored opcode
+    CLS,       // 00E0
+    RET,       // 00EE
+    JP,        // 1NNN
+    CALL,      // 2NNN
+    SE_BYTE,   // 3XNN
+    SNE_BYTE,  // 4XNN
+    SE_REG,    // 5XY0
+    LD_BYTE,   // 6XNN
+    ADD_BYTE,  // 7XNN
+    LD_REG,    // 8XY0
+    OR,        // 8XY1
+    AND,       // 8XY2
+    XOR,       // 8XY3
+    ADD_REG,   // 8XY4
+    SUB,       // 8XY5
+    SHR,       // 8XY6
+    SUBN,      // 8XY7
+    SHL,       // 8XYE
+    SNE_REG,   // 9XY0
+    LD_I,      // ANNN
+    JP_V0,     // BNNN
+    RND,       // CXNN
+    DRW,       // DXYN
+    SKP,       // EX9E
+    SKNP,      // EXA1
+    LD_VX_DT,  // FX07
+    LD_VX_K,   // FX0A
+    LD_DT_VX,  // FX15
+    LD_ST_VX,  // FX18
+    ADD_I,     // FX1E
+    LD_F,      // FX29
+    LD_B,      // FX33
+    LD_MEM,    // FX55
+    LD_REGS,   // FX65
+    SCD,       // 00CN
+    SCR,       // 00FB
+    SCL,       // 00FC
+    EXIT,      // 00FD
+    LOW,       // 00FE
+    HIGH,      // 00FF
+    LD_HF,     // FX30
+    LD_R,      // FX75
+    LD_VX_R,   // FX85
+    SCU,       // 00DN
+    SAVE,      // 5XY2
+    LOAD,      // 5XY3
+    LD_I_LONG, // F000 NNNN
+    PLANE,     // FN01
+    AUDIO,     // F002
+    PITCH,     // FX3A
+    COUNT
+};
+
+/**
+ * @brief A CHIP-8 instruction decoded once and kept for later execution.
+ *
+ * The handler executes the instruction with PC already advanced past it, so
+ * jumps assign PC directly and skips add another 2.
+ */
+struct DecodedOp {
+    using Handler = void (*)(Chip8CPU& cpu, const DecodedOp& op);
+
+    Handler handler;  // nullptr marks a slot that still has to be decoded
+    uint16_t opcode;
+    uint16_t nnn;
+    uint8_t nn;
+    uint8_t x;
+    uint8_t y;
+    OpKind kind;  // Only DXYN needs n, it takes it from opcode
+};
+
+static_assert(sizeof(DecodedOp) == 16, "keep four slots per cache line");
+
+/**
+ * @brief Predecoded instruction table covering the whole address space.
+ *
+ * Slots are filled lazily by the CPU and dropped again whenever one of the
+ * two bytes they were decoded from is written through Memory. The table is
+ * sized for 64 KB but only pages up to the highest slot ever filled are
+ * touched, so a 4 KB program never pays for the rest.
+ *
+ * Chip8CPU::fork() shares one cache between machines with equal memory.
+ * The cache is frozen when it is first shared and never changes again:
+ * misses are decoded but not stored, so the sharers may run on different
+ * threads. A sharer that writes memory moves to an unfrozen copy of its
+ * own, even if it has become the last one holding the frozen cache.
+ */
+class DecodeCache : public MemoryObserver {
+public:
+    static constexpr size_t SIZE = Memory::MEM_SIZE;
+
+    DecodeCache();
+    DecodeCache(const DecodeCache& other);
+    ~DecodeCache() override = default;
+
+    DecodeCache& operator=(const DecodeCache&) = delete;
+
+    DecodedOp& at(uint16_t address) {
+        return ops[address];
+    }
+    /**
+     * @brief The slot for `address`, about to be filled.
+     */
+    DecodedOp& fill(uint16_t address) {
+        used = std::max<size_t>(used, address + 1);
+        return ops[address];
+    }
+    void invalidate(uint16_t address, size_t length);
+    void invalidateAll();
+
+    void onMemoryWrite(uint16_t address, size_t length) override;
+
+    // Set once by Chip8CPU::fork(), read by sharers on any thread. A copy
+    // starts unfrozen.
+    std::atomic<bool> frozen{false};
+
+private:
+    struct Free {
+        void operator()(DecodedOp* ops) const;
+    };
+
+    // calloc'd, so pages past `used` stay untouched zero pages.
+    std::unique_ptr<DecodedOp[], Free> ops;
+    size_t used = 0;  // Slots at and above this are all empty
+};
+}  // namespace CHIP8
@@ -4,64 +4,139 @@
 
 #include <cstring>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
 namespace CHIP8 {
 
+const uint32_t Chip8Display::PALETTE[16] = {
+    0xFF000000, 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555,  // Planes 0-1
+    0xFFAA0000, 0xFFFF5555, 0xFF00AA00, 0xFF55FF55,  // Plane 2
+    0xFF0000AA, 0xFF5555FF, 0xFFAA5500, 0xFFFFFF55,  // Plane 3
+    0xFF00AAAA, 0xFF55FFFF, 0xFFAA00AA, 0xFFFF55FF,  // Planes 2-3
+};
+
 Chip8Display::Chip8Display() {
     SDL_Init(SDL_INIT_VIDEO);
     window = SDL_CreateWindow("CHIP-8 Emulator", SDL_WINDOWPOS_UNDEFINED,
-                              SDL_WINDOWPOS_UNDEFINED, WIDTH * 10, HEIGHT * 10,
+                              SDL_WINDOWPOS_UNDEFINED, WIDTH * 5, HEIGHT * 5,
                               SDL_WINDOW_SHOWN);
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
 }
 
 Chip8Display::~Chip8Display() {
+    SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
 
-void Chip8Display::clear() {
-    memset(pixels, 0, sizeof(pixels));
+#ifdef __SSSE3__
+// Byte `channel` of every palette entry, for looking up 16 pixels at once.
+static __m128i paletteChannel(int channel) {
+    alignas(16) uint8_t bytes[16];
+    for (int i = 0; i < 16; ++i) {
+        bytes[i] = Chip8Display::PALETTE[i] >> (8 * channel);
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
 }
+#endif
 
-bool Chip8Display::drawSprite(int x, int y, const uint8_t* sprite,
-                              int numRows) {
-    bool pixelCollision = false;
-    for (int row = 0; row < numRows; ++row) {
-        uint8_t spriteRow = sprite[row];
-        for (int col = 0; col < 8; ++col) {
-            if ((spriteRow & (0x80 >> col)) != 0) {
-                int currentX = (x + col) % WIDTH;
-                int currentY = (y + row) % HEIGHT;
-                int pixelIndex = currentY * WIDTH + currentX;
-                if (pixels[pixelIndex] == 1) {
-                    pixelCollision = true;
-                }
-                pixels[pixelIndex] ^= 1;
-            }
+void Chip8Display::compositeRow(
+    const uint64_t (&words)[Framebuffer::PLANES], uint32_t* out) {
+#ifdef __SSE2__
+    // Sixteen pixels per step: broadcast each plane's two bytes, test one
+    // bit per byte lane and OR the plane's weight into the colour indices.
+    const __m128i lane_bits =
+        _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1,  // Lane 0 = MSB
+                      -128, 64, 32, 16, 8, 4, 2, 1);
+#ifdef __SSSE3__
+    static const __m128i blue = paletteChannel(0);
+    static const __m128i green = paletteChannel(1);
+    static const __m128i red = paletteChannel(2);
+    static const __m128i alpha = paletteChannel(3);
+#endif
+    for (int i = 0; i < 64 / 16; ++i) {
+        __m128i index = _mm_setzero_si128();
+        for (int p = 0; p < Framebuffer::PLANES; ++p) {
+            uint64_t bits = words[p] >> (48 - 16 * i);
+            __m128i bytes =
+                _mm_set_epi64x((bits & 0xFF) * 0x0101010101010101ull,
+                               ((bits >> 8) & 0xFF) * 0x0101010101010101ull);
+            __m128i mask =
+                _mm_cmpeq_epi8(_mm_and_si128(bytes, lane_bits), lane_bits);
+            index = _mm_or_si128(index,
+                                 _mm_and_si128(mask, _mm_set1_epi8(1 << p)));
+        }
+        uint32_t* px = out + 16 * i;
+#ifdef __SSSE3__
+        // Look every channel up with a byte shuffle and interleave them
+        // back into B, G, R, A pixels.
+        __m128i b = _mm_shuffle_epi8(blue, index);
+        __m128i g = _mm_shuffle_epi8(green, index);
+        __m128i r = _mm_shuffle_epi8(red, index);
+        __m128i a = _mm_shuffle_epi8(alpha, index);
+        __m128i bg_lo = _mm_unpacklo_epi8(b, g);
+        __m128i bg_hi = _mm_unpackhi_epi8(b, g);
+        __m128i ra_lo = _mm_unpacklo_epi8(r, a);
+        __m128i ra_hi = _mm_unpackhi_epi8(r, a);
+        __m128i* dst = reinterpret_cast<__m128i*>(px);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(bg_hi, ra_hi));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(bg_hi, ra_hi));
+#else
+        alignas(16) uint8_t indices[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+        for (int x = 0; x < 16; ++x) {
+            px[x] = PALETTE[indices[x]];
         }
+#endif
     }
-    return pixelCollision;
+#else
+    for (int x = 0; x < 64; ++x) {
+        unsigned index = 0;
+        for (int p = 0; p < Framebuffer::PLANES; ++p) {
+            index |= ((words[p] >> (63 - x)) & 1) << p;
+        }
+        out[x] = PALETTE[index];
+    }
+#endif
 }
 
-void Chip8Display::render() {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            if (pixels[y * WIDTH + x] == 1) {
-                SDL_Rect rect = {x * 10, y * 10, 10, 10};
-                SDL_RenderFillRect(renderer, &rect);
+void Chip8Display::render(const Framebuffer& frame) {
+    if (!renderer) {
+        return;
+    }
+    if (!uploaded_valid ||
+        memcmp(uploaded.planes, frame.planes, sizeof(frame.planes)) != 0) {
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) == 0) {
+            for (int y = 0; y < HEIGHT; ++y) {
+                uint32_t* line = reinterpret_cast<uint32_t*>(
+                    static_cast<uint8_t*>(pixels) + y * pitch);
+                for (int w = 0; w < 2; ++w) {
+                    uint64_t words[Framebuffer::PLANES];
+                    for (int p = 0; p < Framebuffer::PLANES; ++p) {
+                        words[p] = frame.planes[p][y][w];
+                    }
+                    compositeRow(words, line + 64 * w);
+                }
             }
+            SDL_UnlockTexture(texture);
+            uploaded = frame;
+            uploaded_valid = true;
         }
     }
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
     SDL_RenderPresent(renderer);
 }
 
-bool Chip8Display::getPixel(int x, int y) const {
-    return pixels[y * WIDTH + x] == 1;
-}
-
-}  // namespace CHIP8
\ No newline at end of file
+}  // namespace CHIP8
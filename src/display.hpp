@@ -4,46 +4,50 @@
 
 #include <cstdint>
 
+#include "framebuffer.hpp"
+
 namespace CHIP8 {
+
+/**
+ * @brief SDL window that presents a Framebuffer. Holds only host resources;
+ * the pixels themselves belong to the emulated machine.
+ */
 class Chip8Display {
 public:
-    static const int WIDTH = 64;
-    static const int HEIGHT = 32;
+    static const int WIDTH = Framebuffer::WIDTH;
+    static const int HEIGHT = Framebuffer::HEIGHT;
+
+    // Colour of each plane combination: plane 0 alone is white and two
+    // planes give XO-CHIP's four shades.
+    static const uint32_t PALETTE[16];
 
     Chip8Display();
     ~Chip8Display();
 
-    void clear();
+    Chip8Display(const Chip8Display&) = delete;
+    Chip8Display& operator=(const Chip8Display&) = delete;
 
     /**
-     * @brief Draws a sprite at the given coordinates.
+     * @brief Renders `frame` to the screen using SDL.
      *
-     * @param x The x-coordinate to draw the sprite at.
-     * @param y The y-coordinate to draw the sprite at.
-     * @param sprite A pointer to the sprite data.
-     * @param numRows The number of rows in the sprite.
-     * @return True if a pixel collision occurred (a pixel was flipped from 1 to
-     * 0), false otherwise.
+     * The framebuffer is expanded into a streaming texture that is scaled to
+     * the window with a single copy. The upload is skipped when the frame is
+     * unchanged since the previous call.
      */
-    bool drawSprite(int x, int y, const uint8_t* sprite, int numRows);
+    void render(const Framebuffer& frame);
 
     /**
-     * @brief Renders the current state of the display to the screen using SDL.
-     */
-    void render();
-
-    /**
-     * @brief Gets the state of a pixel at the given coordinates.
-     *
-     * @param x The x-coordinate of the pixel.
-     * @param y The y-coordinate of the pixel.
-     * @return True if the pixel is on, false otherwise.
+     * @brief Composites the 64 pixels at one word of every plane into 64
+     * 32-bit pixels, PALETTE[colour index] each.
      */
-    bool getPixel(int x, int y) const;
+    static void compositeRow(const uint64_t (&words)[Framebuffer::PLANES],
+                             uint32_t* out);
 
 private:
-    uint8_t pixels[WIDTH * HEIGHT]{};
+    Framebuffer uploaded;  // What the texture currently shows
+    bool uploaded_valid = false;
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
 };
 }  // namespace CHIP8
@@ -0,0 +1,174 @@
+#include "framebuffer.hpp"
+
+#include <cstring>
+
+namespace CHIP8 {
+
+void Framebuffer::reset() {
+    memset(planes, 0, sizeof(planes));
+    hires = false;
+    plane_mask = 1;
+}
+
+void Framebuffer::clear() {
+    for (int p = 0; p < PLANES; ++p) {
+        if (plane_mask & (1 << p)) {
+            memset(planes[p], 0, sizeof(planes[p]));
+        }
+    }
+}
+
+int Framebuffer::width() const {
+    return hires ? WIDTH : LORES_WIDTH;
+}
+
+int Framebuffer::height() const {
+    return hires ? HEIGHT : LORES_HEIGHT;
+}
+
+int Framebuffer::selectedPlanes() const {
+    int count = 0;
+    for (int p = 0; p < PLANES; ++p) {
+        count += (plane_mask >> p) & 1;
+    }
+    return count;
+}
+
+// Doubles every one of the 16 low bits, for 2x2 low-resolution pixels.
+static inline uint64_t doublePixels(uint64_t bits) {
+    bits = (bits | (bits << 8)) & 0x00FF00FFull;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0Full;
+    bits = (bits | (bits << 2)) & 0x33333333ull;
+    bits = (bits | (bits << 1)) & 0x55555555ull;
+    return bits | (bits << 1);
+}
+
+// The whole sprite row moves as one or two 64-bit words: a sprite at x
+// covers the word x falls in and spills into the next one, which is the
+// first word again when wrapping.
+template <bool CLIP>
+static bool drawPlane(Framebuffer& frame, uint64_t (*rows)[2], int x, int y,
+                      const uint8_t* sprite, int numRows, bool wide) {
+    const int scale = frame.hires ? 1 : 2;
+    const unsigned left = (x % frame.width()) * scale;
+    const unsigned word = left / 64;
+    const unsigned shift = left % 64;
+    const int top = (y % frame.height()) * scale;
+    uint64_t collisions = 0;
+    for (int row = 0; row < numRows; ++row) {
+        uint64_t bits = wide ? (sprite[2 * row] << 8) | sprite[2 * row + 1]
+                             : sprite[row] << 8;
+        bits = frame.hires ? bits << 48 : doublePixels(bits) << 32;
+        uint64_t first = bits >> shift;
+        uint64_t second = shift ? bits << (64 - shift) : 0;
+        if (CLIP && word == 1) {
+            second = 0;
+        }
+        for (int line = 0; line < scale; ++line) {
+            int screen_y = top + row * scale + line;
+            if (CLIP && screen_y >= Framebuffer::HEIGHT) {
+                return collisions != 0;
+            }
+            uint64_t* words = rows[screen_y % Framebuffer::HEIGHT];
+            collisions |= (words[word] & first) | (words[word ^ 1] & second);
+            words[word] ^= first;
+            words[word ^ 1] ^= second;
+        }
+    }
+    return collisions != 0;
+}
+
+template <bool CLIP>
+static bool draw(Framebuffer& frame, int x, int y, const uint8_t* sprite,
+                 int numRows, bool wide) {
+    const int sprite_bytes = numRows * (wide ? 2 : 1);
+    bool collision = false;
+    for (int p = 0; p < Framebuffer::PLANES; ++p) {
+        if (frame.plane_mask & (1 << p)) {
+            collision |= drawPlane<CLIP>(frame, frame.planes[p], x, y, sprite,
+                                         numRows, wide);
+            sprite += sprite_bytes;
+        }
+    }
+    return collision;
+}
+
+bool Framebuffer::drawSprite(int x, int y, const uint8_t* sprite,
+                             int numRows, bool wide) {
+    return draw<false>(*this, x, y, sprite, numRows, wide);
+}
+
+bool Framebuffer::drawSpriteClipped(int x, int y, const uint8_t* sprite,
+                                    int numRows, bool wide) {
+    return draw<true>(*this, x, y, sprite, numRows, wide);
+}
+
+void Framebuffer::scrollUp(int pixels) {
+    if (pixels >= HEIGHT) {
+        clear();
+        return;
+    }
+    for (int p = 0; p < PLANES; ++p) {
+        if (plane_mask & (1 << p)) {
+            auto rows = planes[p];
+            memmove(rows[0], rows[pixels],
+                    (HEIGHT - pixels) * sizeof(rows[0]));
+            memset(rows[HEIGHT - pixels], 0, pixels * sizeof(rows[0]));
+        }
+    }
+}
+
+void Framebuffer::scrollDown(int pixels) {
+    if (pixels >= HEIGHT) {
+        clear();
+        return;
+    }
+    for (int p = 0; p < PLANES; ++p) {
+        if (plane_mask & (1 << p)) {
+            auto rows = planes[p];
+            memmove(rows[pixels], rows[0],
+                    (HEIGHT - pixels) * sizeof(rows[0]));
+            memset(rows[0], 0, pixels * sizeof(rows[0]));
+        }
+    }
+}
+
+void Framebuffer::scrollLeft(int pixels) {
+    for (int p = 0; p < PLANES; ++p) {
+        if (plane_mask & (1 << p)) {
+            for (auto& row : planes[p]) {
+                row[0] = (row[0] << pixels) | (row[1] >> (64 - pixels));
+                row[1] <<= pixels;
+            }
+        }
+    }
+}
+
+void Framebuffer::scrollRight(int pixels) {
+    for (int p = 0; p < PLANES; ++p) {
+        if (plane_mask & (1 << p)) {
+            for (auto& row : planes[p]) {
+                row[1] = (row[1] >> pixels) | (row[0] << (64 - pixels));
+                row[0] >>= pixels;
+            }
+        }
+    }
+}
+
+bool Framebuffer::getPixel(int x, int y) const {
+    return getColor(x, y) != 0;
+}
+
+uint8_t Framebuffer::getColor(int x, int y) const {
+    if (!hires) {
+        x *= 2;
+        y *= 2;
+    }
+    uint8_t color = 0;
+    for (int p = 0; p < PLANES; ++p) {
+        color |= ((planes[p][y][x / 64] >> (63 - x % 64)) & 1) << p;
+    }
+    return color;
+}
+
+}  // namespace CHIP8
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+
+namespace CHIP8 {
+
+/**
+ * @brief The emulated 128x64 screen: up to four bit planes of two uint64_t
+ * per row.
+ *
+ * Bit 63 of planes[p][y][0] is the leftmost pixel (x = 0) and bit 0 of
+ * planes[p][y][1] the rightmost. A pixel's colour is the 4-bit number made
+ * of its bits in every plane, plane 0 being the lowest; classic programs
+ * only ever touch plane 0. In the 64x32 low-resolution mode every pixel
+ * covers a 2x2 block, and coordinates passed to drawSprite() and getPixel()
+ * are in units of the current mode. Plain data so it can live inside
+ * MachineState; presenting it is Chip8Display's job.
+ */
+struct Framebuffer {
+    static const int WIDTH = 128;
+    static const int HEIGHT = 64;
+    static const int LORES_WIDTH = 64;
+    static const int LORES_HEIGHT = 32;
+    static const int PLANES = 4;
+
+    uint64_t planes[PLANES][HEIGHT][2];
+    bool hires;          // SCHIP 00FF/00FE
+    uint8_t plane_mask;  // XO-CHIP FN01, the planes that are drawn on
+
+    /**
+     * @brief Power-on state: lores, every pixel off, plane 0 selected.
+     */
+    void reset();
+
+    /**
+     * @brief Turns every pixel of the selected planes off. The resolution
+     * is kept.
+     */
+    void clear();
+
+    // Size of the current mode.
+    int width() const;
+    int height() const;
+
+    /**
+     * @brief Number of planes in plane_mask, i.e. of sprites a DXYN draws.
+     */
+    int selectedPlanes() const;
+
+    /**
+     * @brief Draws a sprite at the given coordinates.
+     *
+     * With several planes selected, one sprite per plane is read from
+     * consecutive memory, lowest plane first.
+     *
+     * @param x The x-coordinate to draw the sprite at.
+     * @param y The y-coordinate to draw the sprite at.
+     * @param sprite A pointer to the sprite data.
+     * @param numRows The number of rows in the sprite.
+     * @param wide Draw a 16 pixel wide sprite with two bytes per row, as
+     * SCHIP DXY0 does, instead of an 8 pixel wide one.
+     * @return True if a pixel collision occurred (a pixel was flipped from 1 to
+     * 0), false otherwise.
+     */
+    bool drawSprite(int x, int y, const uint8_t* sprite, int numRows,
+                    bool wide = false);
+
+    /**
+     * @brief Like drawSprite(), but the parts of the sprite past the right
+     * and bottom edges are dropped instead of wrapping around. The starting
+     * coordinates still wrap.
+     */
+    bool drawSpriteClipped(int x, int y, const uint8_t* sprite, int numRows,
+                           bool wide = false);
+
+    // SCHIP and XO-CHIP scrolling of the selected planes, in 128x64 pixels
+    // whatever the mode.
+    void scrollUp(int pixels);
+    void scrollDown(int pixels);
+    void scrollLeft(int pixels);
+    void scrollRight(int pixels);
+
+    /**
+     * @brief Gets the state of a pixel at the given coordinates.
+     *
+     * @param x The x-coordinate of the pixel.
+     * @param y The y-coordinate of the pixel.
+     * @return True if the pixel is on in any plane, false otherwise.
+     */
+    bool getPixel(int x, int y) const;
+
+    /**
+     * @brief The colour index of a pixel, one bit per plane.
+     */
+    uint8_t getColor(int x, int y) const;
+};
+
+}  // namespace CHIP8
@@ -12,19 +12,26 @@ static const SDL_Keycode keymap[16] = {
     SDLK_z, SDLK_x, SDLK_c, SDLK_v,  // Z X C V
 };
 
-bool Chip8Keypad::handleInput() {
+bool Chip8Keypad::handleInput(uint16_t& keys) {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
             return false;  // Signal to quit
         }
+        if (event.key.keysym.sym == SDLK_BACKSPACE) {
+            if (event.type == SDL_KEYDOWN) {
+                rewind_held = true;
+            } else if (event.type == SDL_KEYUP) {
+                rewind_held = false;
+            }
+        }
 
         for (int i = 0; i < 16; ++i) {
             if (event.key.keysym.sym == keymap[i]) {
                 if (event.type == SDL_KEYDOWN) {
-                    keys[i] = true;
+                    keys |= 1 << i;
                 } else if (event.type == SDL_KEYUP) {
-                    keys[i] = false;
+                    keys &= ~(1 << i);
                 }
             }
         }
@@ -32,32 +39,12 @@ bool Chip8Keypad::handleInput() {
     return true;  // Continue running
 }
 
-void Chip8Keypad::setKey(uint8_t key, bool pressed) {
-    if (key < 16) {
-        keys[key] = pressed;
-    }
-}
-
-bool Chip8Keypad::isKeyPressed(uint8_t key) const {
-    if (key < 16) {
-        return keys[key];
-    }
-    return false;
+bool Chip8Keypad::isRewindHeld() const {
+    return rewind_held;
 }
 
-int Chip8Keypad::waitForKey() {
-    SDL_Event event;
-    while (true) {
-        if (SDL_WaitEvent(&event)) {
-            if (event.type == SDL_KEYDOWN) {
-                for (int i = 0; i < 16; ++i) {
-                    if (event.key.keysym.sym == keymap[i]) {
-                        return i;
-                    }
-                }
-            }
-        }
-    }
+void Chip8Keypad::waitForInput() {
+    SDL_WaitEvent(nullptr);
 }
 
 }  // namespace CHIP8
\ No newline at end of file
@@ -2,14 +2,29 @@
 #include <cstdint>
 
 namespace CHIP8 {
+/**
+ * @brief Reads the host keyboard through SDL. The pressed keys themselves
+ * are machine state and are passed in as a bitmask, bit n for key n.
+ */
 class Chip8Keypad {
 public:
-    bool handleInput();
-    void setKey(uint8_t key, bool pressed);
-    bool isKeyPressed(uint8_t key) const;
-    int waitForKey();
+    /**
+     * @brief Drains pending SDL events into `keys`.
+     *
+     * @return False once the window was closed.
+     */
+    bool handleInput(uint16_t& keys);
+
+    /**
+     * @brief Sleeps until an SDL event is pending, without taking it off
+     * the queue for handleInput().
+     */
+    void waitForInput();
+
+    // Backspace, held to run the machine backward through its history.
+    bool isRewindHeld() const;
 
 private:
-    bool keys[16]{};
+    bool rewind_held = false;
 };
-}  // namespace CHIP8
\ No newline at end of file
+}  // namespace CHIP8
@@ -0,0 +1,528 @@
+#include "jit.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#ifdef CHIP8_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+namespace CHIP8 {
+
+#ifdef CHIP8_JIT_X86_64
+
+namespace {
+
+constexpr size_t CODE_BUFFER_SIZE = 256 * 1024;
+// Longest instruction sequence emitted per CHIP-8 opcode plus the epilogue.
+constexpr size_t MAX_BYTES_PER_OP = 32;
+constexpr size_t MAX_BLOCK_BYTES =
+    JitEngine::MAX_BLOCK_LENGTH * MAX_BYTES_PER_OP + 16;
+
+constexpr uint8_t V_OFF = offsetof(Register, V);
+constexpr uint8_t I_OFF = offsetof(Register, I);
+constexpr uint8_t PC_OFF = offsetof(Register, PC);
+constexpr uint8_t DT_OFF = offsetof(Register, delay_timer);
+constexpr uint8_t ST_OFF = offsetof(Register, sound_timer);
+
+/**
+ * @brief Emits the handful of x86-64 instructions the translator needs.
+ *
+ * The Register pointer is passed in rdi (System V ABI) and every operand is
+ * addressed as [rdi + disp8]. Only eax, ecx and edx are used as scratch, so
+ * the generated functions need no prologue.
+ */
+class Emitter {
+public:
+    explicit Emitter(uint8_t* out) : start(out), p(out) {
+    }
+
+    size_t size() const {
+        return p - start;
+    }
+
+    // mov byte [rdi+d], imm8
+    void movMemImm8(uint8_t d, uint8_t imm) {
+        emit({0xC6, 0x47, d, imm});
+    }
+    // add byte [rdi+d], imm8
+    void addMemImm8(uint8_t d, uint8_t imm) {
+        emit({0x80, 0x47, d, imm});
+    }
+    // cmp byte [rdi+d], imm8
+    void cmpMemImm8(uint8_t d, uint8_t imm) {
+        emit({0x80, 0x7F, d, imm});
+    }
+    // mov al, [rdi+d]
+    void loadAl(uint8_t d) {
+        emit({0x8A, 0x47, d});
+    }
+    // mov [rdi+d], al
+    void storeAl(uint8_t d) {
+        emit({0x88, 0x47, d});
+    }
+    // mov [rdi+d], dl
+    void storeDl(uint8_t d) {
+        emit({0x88, 0x57, d});
+    }
+    // or/and/xor byte [rdi+d], al
+    void orMemAl(uint8_t d) {
+        emit({0x08, 0x47, d});
+    }
+    void andMemAl(uint8_t d) {
+        emit({0x20, 0x47, d});
+    }
+    void xorMemAl(uint8_t d) {
+        emit({0x30, 0x47, d});
+    }
+    // sub al, [rdi+d]
+    void subAlMem(uint8_t d) {
+        emit({0x2A, 0x47, d});
+    }
+    // cmp al, [rdi+d]
+    void cmpAlMem(uint8_t d) {
+        emit({0x3A, 0x47, d});
+    }
+    // movzx eax/ecx, byte [rdi+d]
+    void movzxEax(uint8_t d) {
+        emit({0x0F, 0xB6, 0x47, d});
+    }
+    void movzxEcx(uint8_t d) {
+        emit({0x0F, 0xB6, 0x4F, d});
+    }
+    // add eax, ecx
+    void addEaxEcx() {
+        emit({0x01, 0xC8});
+    }
+    // cmp eax, ecx
+    void cmpEaxEcx() {
+        emit({0x39, 0xC8});
+    }
+    // cmp eax, imm32
+    void cmpEaxImm(uint32_t imm) {
+        emit({0x3D});
+        emit32(imm);
+    }
+    // add eax, imm32
+    void addEaxImm(uint32_t imm) {
+        emit({0x05});
+        emit32(imm);
+    }
+    // seta dl
+    void setaDl() {
+        emit({0x0F, 0x97, 0xC2});
+    }
+    // and al, imm8
+    void andAlImm(uint8_t imm) {
+        emit({0x24, imm});
+    }
+    // shr al, imm8
+    void shrAlImm(uint8_t imm) {
+        emit({0xC0, 0xE8, imm});
+    }
+    // shr/shl byte [rdi+d], 1
+    void shrMem1(uint8_t d) {
+        emit({0xD0, 0x6F, d});
+    }
+    void shlMem1(uint8_t d) {
+        emit({0xD0, 0x67, d});
+    }
+    // lea eax, [rax+rax*4]
+    void timesFiveEax() {
+        emit({0x8D, 0x04, 0x80});
+    }
+    // mov word [rdi+d], imm16
+    void movMemImm16(uint8_t d, uint16_t imm) {
+        emit({0x66, 0xC7, 0x47, d, static_cast<uint8_t>(imm & 0xFF),
+              static_cast<uint8_t>(imm >> 8)});
+    }
+    // mov word [rdi+d], ax / cx
+    void storeAx(uint8_t d) {
+        emit({0x66, 0x89, 0x47, d});
+    }
+    void storeCx(uint8_t d) {
+        emit({0x66, 0x89, 0x4F, d});
+    }
+    // add word [rdi+d], ax
+    void addMemAx(uint8_t d) {
+        emit({0x66, 0x01, 0x47, d});
+    }
+    // mov ecx/edx, imm32
+    void movEcxImm(uint32_t imm) {
+        emit({0xB9});
+        emit32(imm);
+    }
+    void movEdxImm(uint32_t imm) {
+        emit({0xBA});
+        emit32(imm);
+    }
+    // cmove/cmovne ecx, edx
+    void cmoveEcxEdx() {
+        emit({0x0F, 0x44, 0xCA});
+    }
+    void cmovneEcxEdx() {
+        emit({0x0F, 0x45, 0xCA});
+    }
+    void ret() {
+        emit({0xC3});
+    }
+
+private:
+    void emit(std::initializer_list<uint8_t> bytes) {
+        for (uint8_t b : bytes) {
+            *p++ = b;
+        }
+    }
+    void emit32(uint32_t value) {
+        std::memcpy(p, &value, sizeof value);
+        p += sizeof value;
+    }
+
+    uint8_t* start;
+    uint8_t* p;
+};
+
+// Sets PC past the `skipped` bytes after `address + 2` if the flags say
+// "equal" (or "not equal"), else to `address + 2`. Used by the conditional
+// skip instructions.
+void emitSkip(Emitter& e, uint16_t address, uint16_t skipped,
+              bool skip_if_equal) {
+    e.movEcxImm(address + 2);
+    e.movEdxImm(address + 2 + skipped);
+    if (skip_if_equal) {
+        e.cmoveEcxEdx();
+    } else {
+        e.cmovneEcxEdx();
+    }
+    e.storeCx(PC_OFF);
+}
+
+}  // namespace
+
+JitEngine::JitEngine() {
+    void* buffer = mmap(nullptr, CODE_BUFFER_SIZE,
+                        PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer != MAP_FAILED) {
+        code_buffer = static_cast<uint8_t*>(buffer);
+        code_size = CODE_BUFFER_SIZE;
+    }
+    blocks = std::make_unique<JitBlock[]>(ADDRESS_SPACE);
+}
+
+JitEngine::~JitEngine() {
+    if (code_buffer) {
+        munmap(code_buffer, code_size);
+    }
+}
+
+bool JitEngine::isAvailable() const {
+    return code_buffer != nullptr;
+}
+
+const JitBlock* JitEngine::blockAt(uint16_t address, const uint8_t* memory) {
+    if (!code_buffer || address >= ADDRESS_SPACE - 1) {
+        return nullptr;
+    }
+    if (!looked_up[address]) {
+        translate(address, memory);
+    }
+    const JitBlock* block = &blocks[address];
+    return block->code ? block : nullptr;
+}
+
+void JitEngine::setQuirks(const Quirks& quirks) {
+    this->quirks = quirks;
+    flush();
+}
+
+void JitEngine::flush() {
+    looked_up.reset();
+    translated.reset();
+    code_used = 0;
+}
+
+void JitEngine::onMemoryWrite(uint16_t address, size_t length) {
+    for (size_t i = address; i < address + length && i < ADDRESS_SPACE;
+         ++i) {
+        if (translated[i]) {
+            flush();
+            return;
+        }
+    }
+}
+
+void JitEngine::translate(uint16_t address, const uint8_t* memory) {
+    if (code_size - code_used < MAX_BLOCK_BYTES) {
+        flush();
+    }
+    uint8_t* code = code_buffer + code_used;
+    Emitter e(code);
+
+    uint16_t pc = address;
+    uint16_t length = 0;
+    bool ended = false;
+    while (!ended && length < MAX_BLOCK_LENGTH && pc < ADDRESS_SPACE - 1) {
+        uint16_t opcode = (memory[pc] << 8) | memory[pc + 1];
+        uint16_t nnn = opcode & 0x0FFF;
+        uint8_t nn = opcode & 0x00FF;
+        uint8_t n = opcode & 0x000F;
+        uint8_t x = V_OFF + ((opcode & 0x0F00) >> 8);
+        uint8_t y = V_OFF + ((opcode & 0x00F0) >> 4);
+        uint8_t vf = V_OFF + 0xF;
+        uint8_t source = quirks.shift_vy ? y : x;  // Of 8XY6 and 8XYE
+        // Length of the instruction a skip steps over. XO-CHIP's F000 NNNN
+        // is four bytes, so there the next word is part of the decision.
+        uint16_t group = opcode & 0xF000;
+        bool skips = group == 0x3000 || group == 0x4000 || group == 0x9000 ||
+                     (group == 0x5000 && n != 0x2 && n != 0x3);
+        uint16_t skipped = 2;
+        if (skips && quirks.long_skips) {
+            translated[pc] = true;
+            translated[pc + 1] = true;
+            if (size_t(pc) + 3 >= ADDRESS_SPACE) {
+                break;  // Left to the interpreter
+            }
+            translated[pc + 2] = true;
+            translated[pc + 3] = true;
+            if (memory[pc + 2] == 0xF0 && memory[pc + 3] == 0x00) {
+                skipped = 4;
+            }
+        }
+
+        // Each case mirrors the interpreter handler step by step, including
+        // the order in which VF and Vx are written.
+        bool native = true;
+        switch (group) {
+            case 0x0000:
+                // CLS, RET, the SCHIP 00CN and 00FB-00FF and the XO-CHIP
+                // 00DN need the interpreter, other 0NNN are ignored.
+                native = nn != 0xE0 && nn != 0xEE && nn < 0xFB &&
+                         (nn & 0xF0) != 0xC0 && (nn & 0xF0) != 0xD0;
+                break;
+            case 0x1000:  // JP addr
+                e.movMemImm16(PC_OFF, nnn);
+                ended = true;
+                break;
+            case 0x3000:  // SE Vx, byte
+                e.cmpMemImm8(x, nn);
+                emitSkip(e, pc, skipped, true);
+                ended = true;
+                break;
+            case 0x4000:  // SNE Vx, byte
+                e.cmpMemImm8(x, nn);
+                emitSkip(e, pc, skipped, false);
+                ended = true;
+                break;
+            case 0x5000:  // SE Vx, Vy
+                if (n == 0x2 || n == 0x3) {  // XO-CHIP register range save
+                    native = false;          // and load
+                    break;
+                }
+                e.loadAl(x);
+                e.cmpAlMem(y);
+                emitSkip(e, pc, skipped, true);
+                ended = true;
+                break;
+            case 0x6000:  // LD Vx, byte
+                e.movMemImm8(x, nn);
+                break;
+            case 0x7000:  // ADD Vx, byte
+                e.addMemImm8(x, nn);
+                break;
+            case 0x8000:
+                switch (n) {
+                    case 0x0:  // LD Vx, Vy
+                        e.loadAl(y);
+                        e.storeAl(x);
+                        break;
+                    case 0x1:  // OR Vx, Vy
+                        e.loadAl(y);
+                        e.orMemAl(x);
+                        if (quirks.logic_resets_vf) {
+                            e.movMemImm8(vf, 0);
+                        }
+                        break;
+                    case 0x2:  // AND Vx, Vy
+                        e.loadAl(y);
+                        e.andMemAl(x);
+                        if (quirks.logic_resets_vf) {
+                            e.movMemImm8(vf, 0);
+                        }
+                        break;
+                    case 0x3:  // XOR Vx, Vy
+                        e.loadAl(y);
+                        e.xorMemAl(x);
+                        if (quirks.logic_resets_vf) {
+                            e.movMemImm8(vf, 0);
+                        }
+                        break;
+                    case 0x4:  // ADD Vx, Vy
+                        e.movzxEax(x);
+                        e.movzxEcx(y);
+                        e.addEaxEcx();
+                        e.cmpEaxImm(0xFF);
+                        e.setaDl();
+                        e.storeDl(vf);
+                        e.storeAl(x);
+                        break;
+                    case 0x5:  // SUB Vx, Vy
+                        e.movzxEax(x);
+                        e.movzxEcx(y);
+                        e.cmpEaxEcx();
+                        e.setaDl();
+                        e.storeDl(vf);
+                        e.loadAl(x);
+                        e.subAlMem(y);
+                        e.storeAl(x);
+                        break;
+                    case 0x6:  // SHR Vx
+                        e.loadAl(source);
+                        e.andAlImm(0x1);
+                        e.storeAl(vf);
+                        if (source != x) {
+                            e.loadAl(source);
+                            e.storeAl(x);
+                        }
+                        e.shrMem1(x);
+                        break;
+                    case 0x7:  // SUBN Vx, Vy
+                        e.movzxEax(y);
+                        e.movzxEcx(x);
+                        e.cmpEaxEcx();
+                        e.setaDl();
+                        e.storeDl(vf);
+                        e.loadAl(y);
+                        e.subAlMem(x);
+                        e.storeAl(x);
+                        break;
+                    case 0xE:  // SHL Vx
+                        e.loadAl(source);
+                        e.shrAlImm(7);
+                        e.storeAl(vf);
+                        if (source != x) {
+                            e.loadAl(source);
+                            e.storeAl(x);
+                        }
+                        e.shlMem1(x);
+                        break;
+                }
+                break;
+            case 0x9000:  // SNE Vx, Vy
+                e.loadAl(x);
+                e.cmpAlMem(y);
+                emitSkip(e, pc, skipped, false);
+                ended = true;
+                break;
+            case 0xA000:  // LD I, addr
+                e.movMemImm16(I_OFF, nnn);
+                break;
+            case 0xB000:  // JP V0, addr
+                e.movzxEax(quirks.jump_vx ? x : V_OFF);
+                e.addEaxImm(nnn);
+                e.storeAx(PC_OFF);
+                ended = true;
+                break;
+            case 0xE000:
+                native = nn != 0x9E && nn != 0xA1;  // Other EXNN are ignored
+                break;
+            case 0xF000:
+                switch (nn) {
+                    case 0x07:  // LD Vx, DT
+                        e.loadAl(DT_OFF);
+                        e.storeAl(x);
+                        break;
+                    case 0x15:  // LD DT, Vx
+                        e.loadAl(x);
+                        e.storeAl(DT_OFF);
+                        break;
+                    case 0x18:  // LD ST, Vx
+                        e.loadAl(x);
+                        e.storeAl(ST_OFF);
+                        break;
+                    case 0x1E:  // ADD I, Vx
+                        e.movzxEax(x);
+                        e.addMemAx(I_OFF);
+                        break;
+                    case 0x29:  // LD F, Vx
+                        e.movzxEax(x);
+                        e.timesFiveEax();
+                        e.storeAx(I_OFF);
+                        break;
+                    case 0x00:
+                    case 0x01:
+                    case 0x02:
+                    case 0x0A:
+                    case 0x30:
+                    case 0x33:
+                    case 0x3A:
+                    case 0x55:
+                    case 0x65:
+                    case 0x75:
+                    case 0x85:
+                        native = false;
+                        break;
+                }
+                break;
+            default:  // CALL, RND and DRW need the interpreter
+                native = false;
+                break;
+        }
+
+        // Remember the bytes this decision was based on, including those of
+        // an instruction that ended the block without being translated.
+        translated[pc] = true;
+        translated[pc + 1] = true;
+        if (!native) {
+            break;
+        }
+        ++length;
+        pc += 2;
+    }
+
+    JitBlock& block = blocks[address];
+    looked_up[address] = true;
+    if (length == 0) {
+        block.code = nullptr;
+        block.length = 0;
+        return;
+    }
+    if (!ended) {
+        e.movMemImm16(PC_OFF, pc);
+    }
+    e.ret();
+
+    block.code = reinterpret_cast<JitBlock::Code>(code);
+    block.length = length;
+    code_used += e.size();
+}
+
+#else  // !CHIP8_JIT_X86_64
+
+JitEngine::JitEngine() {
+}
+
+JitEngine::~JitEngine() {
+}
+
+bool JitEngine::isAvailable() const {
+    return false;
+}
+
+const JitBlock* JitEngine::blockAt(uint16_t address, const uint8_t* memory) {
+    return nullptr;
+}
+
+void JitEngine::setQuirks(const Quirks& quirks) {
+}
+
+void JitEngine::flush() {
+}
+
+void JitEngine::onMemoryWrite(uint16_t address, size_t length) {
+}
+
+#endif  // CHIP8_JIT_X86_64
+
+}  // namespace CHIP8
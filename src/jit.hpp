@@ -0,0 +1,89 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "memory.hpp"
+#include "quirks.hpp"
+#include "register.hpp"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define CHIP8_JIT_X86_64 1
+#endif
+
+namespace CHIP8 {
+
+/**
+ * @brief A straight-line run of CHIP-8 instructions translated to native code.
+ *
+ * Running the block executes `length` instructions against the registers and
+ * leaves PC at the next instruction to execute. Blocks only contain
+ * instructions that touch nothing but the Register struct; everything else
+ * (stack, memory, display, keypad, RNG) ends the block and is left to the
+ * interpreter.
+ */
+struct JitBlock {
+    using Code = void (*)(Register* reg);
+
+    Code code;        // nullptr if nothing at this address can be translated
+    uint16_t length;  // Number of CHIP-8 instructions the block executes
+};
+
+/**
+ * @brief x86-64 dynamic recompiler with a code cache keyed by start address.
+ *
+ * The cache is flushed as a whole when a write hits memory that any cached
+ * block was translated from. Only the first 4 KB are translated; XO-CHIP
+ * code above that runs in the interpreter. On hosts other than x86-64 Unix
+ * the engine reports itself as unavailable and never returns a block.
+ */
+class JitEngine : public MemoryObserver {
+public:
+    static constexpr size_t ADDRESS_SPACE = 4096;
+    static constexpr size_t MAX_BLOCK_LENGTH = 64;
+
+    JitEngine();
+    ~JitEngine() override;
+
+    JitEngine(const JitEngine&) = delete;
+    JitEngine& operator=(const JitEngine&) = delete;
+
+    bool isAvailable() const;
+
+    /**
+     * @brief Looks up the block starting at `address`, translating it from
+     * `memory` on a miss.
+     *
+     * @return The block, or nullptr if the instruction at `address` has to
+     * be run by the interpreter.
+     */
+    const JitBlock* blockAt(uint16_t address, const uint8_t* memory);
+
+    /**
+     * @brief Translates with `quirks` from now on, flushing the cache. The
+     * quirks are resolved at translation time and cost nothing in the code.
+     */
+    void setQuirks(const Quirks& quirks);
+
+    /**
+     * @brief Drops every translated block and resets the code buffer.
+     */
+    void flush();
+
+    void onMemoryWrite(uint16_t address, size_t length) override;
+
+private:
+    void translate(uint16_t address, const uint8_t* memory);
+
+    uint8_t* code_buffer = nullptr;
+    size_t code_size = 0;
+    size_t code_used = 0;
+    Quirks quirks = quirksOf(QuirkProfile::DEFAULT);
+
+    std::unique_ptr<JitBlock[]> blocks;
+    std::bitset<ADDRESS_SPACE> looked_up;   // blocks[addr] holds a result
+    std::bitset<ADDRESS_SPACE> translated;  // Bytes read by the translator
+};
+
+}  // namespace CHIP8
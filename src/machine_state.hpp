@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "framebuffer.hpp"
+#include "memory.hpp"
+#include "register.hpp"
+#include "rng.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief Everything the emulated machine is, in one block of plain data.
+ *
+ * Copying a MachineState clones the machine; nothing in it points anywhere.
+ * The registers, keys and RNG share the first cache line and the stack
+ * follows, ahead of the framebuffer and memory. Host-side resources (window, decoded
+ * instruction cache, JIT code) live in Chip8CPU beside it.
+ */
+struct alignas(64) MachineState {
+    Register reg;
+    uint16_t keys;  // Bit n set while key n is down
+    Xoshiro128 rng;
+    uint16_t stack[16];
+    uint8_t rpl[16];  // SCHIP FX75/FX85 flag registers
+    uint8_t audio_pattern[16];  // XO-CHIP F002, 128 1-bit samples
+    uint8_t pitch;              // XO-CHIP FX3A, 64 plays at 4000 Hz
+    // FX0A in progress: keys already down when it began do not count until
+    // released, and it completes when a key pressed since is released.
+    bool key_waiting;
+    uint16_t key_wait_ignored;
+    uint16_t key_wait_pressed;
+    Framebuffer display;
+    Memory memory;
+
+    /**
+     * @brief Power-on state: everything zero, PC at the ROM start, plane 0
+     * selected and a square wave as the audio pattern, so ROMs that never
+     * load one still beep.
+     */
+    void reset();
+};
+static_assert(std::is_trivially_copyable<MachineState>::value &&
+                  std::is_standard_layout<MachineState>::value,
+              "machine state is copied and moved with memcpy");
+static_assert(offsetof(MachineState, rng) + sizeof(Xoshiro128) <= 64,
+              "registers, keys and RNG share one cache line");
+
+inline void MachineState::reset() {
+    *this = MachineState();
+    reg.reset();
+    display.reset();
+    std::memset(audio_pattern, 0xF0, sizeof audio_pattern);  // 500 Hz
+    pitch = 64;
+}
+
+}  // namespace CHIP8
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <thread>
 #include <string>
@@ -7,16 +8,227 @@
 #include "debugger.hpp"
 #include "debugger_cli.hpp"
 
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <ROM file> [--debug] [--engine <name>] [--memory <name>]"
+              << " [--quirks <name>] [--quirks-db <file>] [--trace <file>]"
+              << " [--seed <n>] [--ipf <n> | --hz <n>] [--turbo]"
+              << " [--load-state <file>] [--rewind <MB>]"
+              << " [--record <file> | --replay <file>]"
+              << " [--audio-buffer <n>] [--audio-latency <ms>] [--mute]"
+              << std::endl;
+    std::cerr << "  --debug: Start in debug mode" << std::endl;
+    std::cerr << "  --engine: interpreter (default), threaded or jit"
+              << std::endl;
+    std::cerr << "  --memory: Out-of-range accesses, checked (default), masked "
+                 "or trap"
+              << std::endl;
+    std::cerr << "  --quirks: default, vip, schip or xochip; overrides the "
+                 "database"
+              << std::endl;
+    std::cerr << "  --quirks-db: Pick the quirk profile by ROM from this file"
+              << std::endl;
+    std::cerr << "  --trace: Write a binary instruction trace, read it back "
+                 "with chip8-tracedump"
+              << std::endl;
+    std::cerr << "  --seed: Seed for the CXNN random generator" << std::endl;
+    std::cerr << "  --ipf: Instructions per 60 Hz frame (default "
+              << CHIP8::Chip8CPU::DEFAULT_CYCLES_PER_FRAME << ")" << std::endl;
+    std::cerr << "  --hz: CPU speed in instructions per second" << std::endl;
+    std::cerr << "  --turbo: Run as fast as the host allows" << std::endl;
+    std::cerr << "  --load-state: Start from a state saved with saveState()"
+              << std::endl;
+    std::cerr << "  --rewind: Rewind history size, 0 to disable (default "
+              << (CHIP8::Chip8CPU::DEFAULT_REWIND_BYTES >> 20)
+              << "); hold Backspace to rewind" << std::endl;
+    std::cerr << "  --record: Write the keys of every frame to an input movie"
+              << std::endl;
+    std::cerr << "  --replay: Play an input movie instead of the keyboard"
+              << std::endl;
+    std::cerr << "  --audio-buffer: Samples per audio device buffer (default "
+              << CHIP8::AudioConfig().device_samples << ")" << std::endl;
+    std::cerr << "  --audio-latency: Most milliseconds a frame's sound may lag "
+                 "(default "
+              << CHIP8::AudioConfig().max_latency_ms << ")" << std::endl;
+    std::cerr << "  --mute: Play no sound" << std::endl;
+}
+
+static void printRunStats(const CHIP8::RunStats& stats) {
+    if (stats.wall_seconds <= 0) {
+        return;
+    }
+    auto share = [&stats](double seconds) {
+        return 100.0 * seconds / stats.wall_seconds;
+    };
+    std::cerr << std::fixed << std::setprecision(2)
+              << stats.instructions / stats.wall_seconds / 1e6 << " MIPS, "
+              << stats.frames / stats.wall_seconds << " frames/s over "
+              << stats.wall_seconds << " s\n"
+              << std::setprecision(1) << "  cpu " << share(stats.cpu_seconds)
+              << "%, timers " << share(stats.timer_seconds) << "%, input "
+              << share(stats.input_seconds) << "%, render "
+              << share(stats.render_seconds) << "%, rewind "
+              << share(stats.rewind_seconds) << "%, sleep "
+              << share(stats.sleep_seconds) << "%" << std::endl;
+}
+
+static void printMemoryFault(const CHIP8::MemoryFault& fault) {
+    static const char* const kinds[] = {"read", "write", "execute"};
+    std::cerr << "Memory fault: " << kinds[fault.kind] << " at 0x" << std::hex
+              << fault.address << " by the instruction at 0x" << fault.pc
+              << std::dec << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2 || argc > 3) {
-        std::cerr << "Usage: " << argv[0] << " <ROM file> [--debug]" << std::endl;
-        std::cerr << "  --debug: Start in debug mode" << std::endl;
+    if (argc < 2) {
+        printUsage(argv[0]);
         return 1;
     }
     std::string path = argv[1];
-    bool debug_mode = (argc == 3 && std::string(argv[2]) == "--debug");
+    bool debug_mode = false;
+    bool turbo = false;
+    bool mute = false;
+    bool custom_audio = false;
+    CHIP8::AudioConfig audio_config;
+    CHIP8::Chip8Engine engine = CHIP8::Chip8Engine::INTERPRETER;
+    CHIP8::MemoryPolicy memory_policy = CHIP8::MemoryPolicy::CHECKED;
+    bool has_quirks = false;
+    CHIP8::QuirkProfile quirks = CHIP8::QuirkProfile::DEFAULT;
+    std::string quirks_db_path;
+    std::string trace_path;
+    std::string state_path;
+    std::string record_path;
+    std::string replay_path;
+    bool seeded = false;
+    uint64_t seed = 0;
+    uint32_t cycles_per_frame = CHIP8::Chip8CPU::DEFAULT_CYCLES_PER_FRAME;
+    uint32_t clock_hz = 0;  // Overrides cycles_per_frame when set
+    size_t rewind_bytes = CHIP8::Chip8CPU::DEFAULT_REWIND_BYTES;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--debug") {
+            debug_mode = true;
+        } else if (arg == "--turbo") {
+            turbo = true;
+        } else if (arg == "--mute") {
+            mute = true;
+        } else if (arg == "--engine" && i + 1 < argc &&
+                   CHIP8::parseEngineName(argv[i + 1], engine)) {
+            ++i;
+        } else if (arg == "--memory" && i + 1 < argc &&
+                   CHIP8::parseMemoryPolicyName(argv[i + 1], memory_policy)) {
+            ++i;
+        } else if (arg == "--quirks" && i + 1 < argc &&
+                   CHIP8::parseQuirkProfileName(argv[i + 1], quirks)) {
+            has_quirks = true;
+            ++i;
+        } else if (arg == "--quirks-db" && i + 1 < argc) {
+            quirks_db_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--load-state" && i + 1 < argc) {
+            state_path = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if ((arg == "--seed" || arg == "--ipf" || arg == "--hz" ||
+                    arg == "--rewind" || arg == "--audio-buffer" ||
+                    arg == "--audio-latency") &&
+                   i + 1 < argc) {
+            uint64_t value;
+            try {
+                value = std::stoull(argv[++i], nullptr, 0);
+            } catch (...) {
+                std::cerr << "Invalid value for " << arg << std::endl;
+                return 1;
+            }
+            if (arg == "--seed") {
+                seed = value;
+                seeded = true;
+            } else if (arg == "--rewind") {
+                rewind_bytes = static_cast<size_t>(value) << 20;
+            } else if (arg == "--audio-buffer") {
+                audio_config.device_samples = static_cast<int>(value);
+                custom_audio = true;
+            } else if (arg == "--audio-latency") {
+                audio_config.max_latency_ms = static_cast<int>(value);
+                custom_audio = true;
+            } else if (arg == "--ipf") {
+                cycles_per_frame = static_cast<uint32_t>(value);
+            } else {
+                clock_hz = static_cast<uint32_t>(value);
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (!record_path.empty() && !replay_path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
     try {
-        CHIP8::Chip8CPU cpu(CHIP8::Chip8Mode::NORMAL, path);
+        auto image = CHIP8::RomCache::global().load(path);
+        if (!image) {
+            std::cerr << "Error: Failed to load ROM: " << path << std::endl;
+            return 1;
+        }
+        if (!has_quirks && !quirks_db_path.empty()) {
+            CHIP8::QuirkDatabase database;
+            if (!database.load(quirks_db_path)) {
+                std::cerr << "Cannot read quirk database " << quirks_db_path
+                          << std::endl;
+                return 1;
+            }
+            database.lookup(image->hash, quirks);
+        }
+        CHIP8::Chip8CPU cpu(CHIP8::Chip8Mode::NORMAL, *image);
+        if (!cpu.setEngine(engine)) {
+            std::cerr << "Engine " << CHIP8::engineName(engine)
+                      << " is not available, using the interpreter"
+                      << std::endl;
+        }
+        if (clock_hz > 0) {
+            cpu.setClockHz(clock_hz);
+        } else {
+            cpu.setCyclesPerFrame(cycles_per_frame);
+        }
+        cpu.setMemoryPolicy(memory_policy);
+        cpu.setQuirkProfile(quirks);
+        cpu.setTurbo(turbo);
+        cpu.setRewindCapacity(rewind_bytes);
+        if (mute) {
+            cpu.closeAudio();
+        } else if (custom_audio && !cpu.setAudio(audio_config)) {
+            std::cerr << "Cannot open an audio device, running without sound"
+                      << std::endl;
+        }
+        if (seeded) {
+            cpu.seedRandom(seed);
+        }
+        if (!state_path.empty() && !cpu.loadStateFromFile(state_path)) {
+            std::cerr << "Cannot load state from " << state_path << std::endl;
+            return 1;
+        }
+        if (!replay_path.empty() && !cpu.startReplay(replay_path)) {
+            std::cerr << "Cannot replay movie " << replay_path << std::endl;
+            return 1;
+        }
+        if (!record_path.empty() && !cpu.startRecording(record_path)) {
+            std::cerr << "Cannot record movie to " << record_path << std::endl;
+            return 1;
+        }
+        if (!trace_path.empty() && !cpu.startTrace(trace_path, true)) {
+#ifdef CHIP8_TRACE
+            std::cerr << "Cannot write trace to " << trace_path << std::endl;
+#else
+            std::cerr << "Tracing is compiled out, rebuild with "
+                         "-DCHIP8_TRACE=ON"
+                      << std::endl;
+#endif
+            return 1;
+        }
         if (debug_mode) {
             std::cout << "Starting CHIP-8 Debugger" << std::endl;
             std::cout << "ROM loaded: " << path << std::endl;
@@ -25,6 +237,11 @@ int main(int argc, char* argv[]) {
             cli.run();
         } else {
             cpu.run();
+            printRunStats(cpu.getRunStats());
+            if (const CHIP8::MemoryFault* fault = cpu.getMemoryFault()) {
+                printMemoryFault(*fault);
+                return 2;
+            }
         }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -32,4 +249,4 @@ int main(int argc, char* argv[]) {
     }
     
     return 0;
-}
\ No newline at end of file
+}
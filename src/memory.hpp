@@ -1,35 +1,94 @@
 #pragma once
-#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
-#include <string>
-#include <vector>
-
-#include "test_access.hpp"
 
 namespace CHIP8 {
-class Memory {
+/**
+ * @brief Gets notified about every write the CPU makes to emulated memory,
+ * so state derived from memory contents (e.g. decoded instructions) can be
+ * dropped.
+ */
+class MemoryObserver {
 public:
-    Memory();
-    ~Memory() = default;
-    void reset();
+    virtual ~MemoryObserver() = default;
+    virtual void onMemoryWrite(uint16_t address, size_t length) = 0;
+};
+
+/**
+ * @brief What the CPU does with an address past the end of memory.
+ */
+enum class MemoryPolicy : uint8_t {
+    CHECKED,   // Reads give 0 and writes are dropped
+    MASKED,    // Addresses wrap around, no range checks at all
+    TRAPPING,  // The instruction faults and execution stops
+};
+
+// Compile-time forms of MemoryPolicy. The CPU core is instantiated once per
+// policy, so the masked core carries no range checks on its memory path.
+// The core adds MEMORY_SIZE, the size of the address space it runs in.
+struct CheckedAccess {
+    static constexpr MemoryPolicy POLICY = MemoryPolicy::CHECKED;
+    static constexpr bool WRAPS = false;
+    static constexpr bool TRAPS = false;
+};
+
+struct MaskedAccess {
+    static constexpr MemoryPolicy POLICY = MemoryPolicy::MASKED;
+    static constexpr bool WRAPS = true;
+    static constexpr bool TRAPS = false;
+};
+
+struct TrappingAccess {
+    static constexpr MemoryPolicy POLICY = MemoryPolicy::TRAPPING;
+    static constexpr bool WRAPS = false;
+    static constexpr bool TRAPS = true;
+};
+
+/**
+ * @brief The address space as plain data inside MachineState.
+ *
+ * Storage covers XO-CHIP's 64 KB; every other profile addresses only the
+ * first CLASSIC_SIZE bytes, and Chip8CPU copies, snapshots and forks only
+ * the part in use. Writes go through Chip8CPU so that its
+ * MemoryObservers hear about them; storing into `bytes` directly bypasses
+ * them.
+ */
+struct Memory {
+    static constexpr size_t MEM_SIZE = 0x10000;
+    static constexpr size_t CLASSIC_SIZE = 0x1000;
+    static constexpr uint16_t ROM_START_ADDR = 0x200;
+    static constexpr uint16_t FONT_ADDR = 0x000;        // 4x5 digits, FX29
+    static constexpr uint16_t LARGE_FONT_ADDR = 0x050;  // 8x10 digits, FX30
+
+    uint8_t bytes[MEM_SIZE];
+
+    static bool isLegalAddr(uint16_t address);
     std::optional<uint8_t> readByte(uint16_t address) const;
-    bool writeByte(uint16_t address, uint8_t value);
     std::optional<uint16_t> readWord(uint16_t address) const;
-    bool writeWord(uint16_t address, uint16_t value);
-    void loadFontset(const uint8_t* fontset, size_t size);
-    const uint8_t* getRawMemory() const;
-    uint8_t* getRawMemory();
-    static bool isLegalAddr(uint16_t address);
-
-    bool loadROM(const std::string& filename);
-    void loadROM(const std::vector<uint8_t>& data);
 
-private:
-    static const size_t MEM_SIZE = 4096;
-    ::std::unique_ptr<uint8_t[]> mem;
+    /**
+     * @brief Maps `address` into the Access::MEMORY_SIZE bytes of memory
+     * under Access.
+     *
+     * @return False if the address is out of range and the access must be
+     * skipped; never for a wrapping policy.
+     */
+    template <class Access>
+    static bool resolve(uint32_t& address) {
+        if (Access::WRAPS) {
+            address &= Access::MEMORY_SIZE - 1;
+            return true;
+        }
+        return address < Access::MEMORY_SIZE;
+    }
 
-    // Friend class for testing
-    friend class Chip8TestAccess;
+    /**
+     * @brief Reads a byte under Access, 0 for a skipped address.
+     */
+    template <class Access>
+    uint8_t load(uint32_t address) const {
+        return resolve<Access>(address) ? bytes[address] : 0;
+    }
 };
 }  // namespace CHIP8
@@ -0,0 +1,130 @@
+#include "movie.hpp"
+
+#include <cstring>
+
+namespace CHIP8 {
+
+namespace {
+
+void writeVarint(std::FILE* file, uint64_t value) {
+    uint8_t bytes[10];
+    size_t length = 0;
+    do {
+        bytes[length] = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            bytes[length] |= 0x80;
+        }
+        ++length;
+    } while (value);
+    std::fwrite(bytes, 1, length, file);
+}
+
+bool readVarint(std::FILE* file, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = std::fgetc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+MovieRecorder::~MovieRecorder() {
+    close();
+}
+
+bool MovieRecorder::open(const std::string& path,
+                         const MovieFileHeader& header,
+                         const SaveState& start) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fwrite(&header, sizeof header, 1, file);
+    std::fwrite(&start, sizeof start, 1, file);
+    frames = 0;
+    last_frame = 0;
+    return true;
+}
+
+void MovieRecorder::close() {
+    if (!file) {
+        return;
+    }
+    if (frames > 0) {
+        writeEvent(last_keys);
+    }
+    std::fclose(file);
+    file = nullptr;
+}
+
+void MovieRecorder::frame(uint16_t keys) {
+    if (frames == 0 || keys != last_keys) {
+        writeEvent(keys);
+    }
+    ++frames;
+}
+
+void MovieRecorder::writeEvent(uint16_t keys) {
+    writeVarint(file, frames - last_frame);
+    uint8_t bytes[2] = {uint8_t(keys), uint8_t(keys >> 8)};
+    std::fwrite(bytes, 1, sizeof bytes, file);
+    last_frame = frames;
+    last_keys = keys;
+}
+
+bool MoviePlayer::open(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    MovieFileHeader header;
+    bool ok = std::fread(&header, sizeof header, 1, file) == 1 &&
+              std::memcmp(header.magic, "C8MV", 4) == 0 &&
+              header.version == MOVIE_VERSION &&
+              header.state_size == sizeof(SaveState) &&
+              std::fread(&start_state, sizeof start_state, 1, file) == 1;
+    std::vector<MovieEvent> read;
+    uint64_t frame = 0;
+    uint64_t delta;
+    while (ok && readVarint(file, delta)) {
+        uint8_t bytes[2];
+        if (std::fread(bytes, 1, sizeof bytes, file) != sizeof bytes) {
+            ok = false;
+            break;
+        }
+        frame += delta;
+        read.push_back({frame, uint16_t(bytes[0] | (bytes[1] << 8))});
+    }
+    ok = ok && std::feof(file) && !read.empty();
+    std::fclose(file);
+    if (!ok) {
+        return false;
+    }
+    file_header = header;
+    events = std::move(read);
+    next_event = 0;
+    next_frame = 0;
+    keys = 0;
+    return true;
+}
+
+uint16_t MoviePlayer::frame() {
+    while (next_event < events.size() &&
+           events[next_event].frame <= next_frame) {
+        keys = events[next_event++].keys;
+    }
+    ++next_frame;
+    return keys;
+}
+
+}  // namespace CHIP8
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "save_state.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief Start of an input movie file.
+ *
+ * The header is followed by the SaveState the recording started from and
+ * then by one event per keypad change: the number of frames since the
+ * previous event as an unsigned LEB128 varint, and the new key bitmask as
+ * two little-endian bytes. The first event is at frame 0 and the last one
+ * repeats the final keys at the frame the recording stopped, so a movie
+ * that holds a key for a minute costs a few bytes past the state.
+ */
+struct MovieFileHeader {
+    char magic[4];  // "C8MV"
+    uint16_t version;
+    uint8_t quirk_profile;  // QuirkProfile of the recorded machine
+    uint8_t memory_policy;  // MemoryPolicy of the recorded machine
+    uint32_t cycles_per_frame;
+    uint32_t state_size;  // sizeof(SaveState) of the writer
+};
+
+static constexpr uint16_t MOVIE_VERSION = 2;
+
+struct MovieEvent {
+    uint64_t frame;
+    uint16_t keys;
+};
+
+/**
+ * @brief Writes the keypad state of every frame to a movie file, one event
+ * per change.
+ */
+class MovieRecorder {
+public:
+    MovieRecorder() = default;
+    ~MovieRecorder();
+
+    MovieRecorder(const MovieRecorder&) = delete;
+    MovieRecorder& operator=(const MovieRecorder&) = delete;
+
+    bool open(const std::string& path, const MovieFileHeader& header,
+              const SaveState& start);
+
+    /**
+     * @brief Writes the end marker and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Records the keys the next frame runs with.
+     */
+    void frame(uint16_t keys);
+
+private:
+    void writeEvent(uint16_t keys);
+
+    std::FILE* file = nullptr;
+    uint64_t frames = 0;      // Frames recorded so far
+    uint64_t last_frame = 0;  // Frame of the last event written
+    uint16_t last_keys = 0;
+};
+
+/**
+ * @brief A movie file read back into memory, played one frame at a time.
+ */
+class MoviePlayer {
+public:
+    /**
+     * @return False if the file is missing, truncated or of another
+     * version.
+     */
+    bool open(const std::string& path);
+
+    const MovieFileHeader& header() const {
+        return file_header;
+    }
+    const SaveState& start() const {
+        return start_state;
+    }
+
+    /**
+     * @brief The keys of the next frame, or the final keys once finished().
+     */
+    uint16_t frame();
+
+    bool finished() const {
+        return next_frame >= length();
+    }
+
+    /**
+     * @brief Number of frames recorded.
+     */
+    uint64_t length() const {
+        return events.empty() ? 0 : events.back().frame;
+    }
+
+private:
+    MovieFileHeader file_header = {};
+    SaveState start_state;
+    std::vector<MovieEvent> events;
+    size_t next_event = 0;
+    uint64_t next_frame = 0;
+    uint16_t keys = 0;
+};
+
+}  // namespace CHIP8
@@ -0,0 +1,76 @@
+#include "quirks.hpp"
+
+#include <fstream>
+#include <sstream>
+
+namespace CHIP8 {
+
+bool parseQuirkProfileName(const std::string& name, QuirkProfile& profile) {
+    if (name == "default") {
+        profile = QuirkProfile::DEFAULT;
+    } else if (name == "vip") {
+        profile = QuirkProfile::VIP;
+    } else if (name == "schip") {
+        profile = QuirkProfile::SCHIP;
+    } else if (name == "xochip") {
+        profile = QuirkProfile::XOCHIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* quirkProfileName(QuirkProfile profile) {
+    switch (profile) {
+        case QuirkProfile::DEFAULT:
+            return "default";
+        case QuirkProfile::VIP:
+            return "vip";
+        case QuirkProfile::SCHIP:
+            return "schip";
+        case QuirkProfile::XOCHIP:
+            return "xochip";
+    }
+    return "unknown";
+}
+
+bool QuirkDatabase::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string hash;
+        std::string name;
+        if (!(fields >> hash) || hash[0] == '#') {
+            continue;
+        }
+        QuirkProfile profile;
+        if (!(fields >> name) || !parseQuirkProfileName(name, profile)) {
+            return false;
+        }
+        try {
+            add(std::stoull(hash, nullptr, 16), profile);
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuirkDatabase::add(uint64_t rom_hash, QuirkProfile profile) {
+    profiles[rom_hash] = profile;
+}
+
+bool QuirkDatabase::lookup(uint64_t rom_hash, QuirkProfile& profile) const {
+    auto it = profiles.find(rom_hash);
+    if (it == profiles.end()) {
+        return false;
+    }
+    profile = it->second;
+    return true;
+}
+
+}  // namespace CHIP8
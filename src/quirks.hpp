@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "memory.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief Sets of behaviours that differ between CHIP-8 implementations.
+ *
+ * DEFAULT is what this emulator has always done. VIP is the original
+ * COSMAC VIP interpreter, SCHIP is SUPER-CHIP 1.1 and XOCHIP is Octo's
+ * XO-CHIP.
+ */
+enum class QuirkProfile : uint8_t { DEFAULT, VIP, SCHIP, XOCHIP };
+
+/**
+ * @brief The behaviours a QuirkProfile selects.
+ */
+struct Quirks {
+    bool shift_vy;         // 8XY6/8XYE shift Vy into Vx instead of Vx
+    bool increment_i;      // FX55/FX65 leave I at I + X + 1
+    bool jump_vx;          // BXNN jumps to XNN + VX instead of NNN + V0
+    bool logic_resets_vf;  // 8XY1/8XY2/8XY3 clear VF
+    bool clip_sprites;     // Sprites stop at the screen edges, not wrap
+    bool long_skips;       // Skips step over all of a 4-byte F000 NNNN
+    uint32_t memory_size;  // Addressable bytes, a power of two
+};
+
+constexpr Quirks quirksOf(QuirkProfile profile) {
+    switch (profile) {
+        case QuirkProfile::VIP:
+            return {true, true, false, true, true, false,
+                    Memory::CLASSIC_SIZE};
+        case QuirkProfile::SCHIP:
+            return {false, false, true, false, true, false,
+                    Memory::CLASSIC_SIZE};
+        case QuirkProfile::XOCHIP:
+            return {true, true, false, false, false, true, Memory::MEM_SIZE};
+        case QuirkProfile::DEFAULT:
+            break;
+    }
+    return {false, false, false, false, false, false, Memory::CLASSIC_SIZE};
+}
+
+/**
+ * @brief Parses "default", "vip", "schip" or "xochip".
+ *
+ * @return False if `name` is not a profile name.
+ */
+bool parseQuirkProfileName(const std::string& name, QuirkProfile& profile);
+const char* quirkProfileName(QuirkProfile profile);
+
+/**
+ * @brief Maps ROM contents to the profile they were written for.
+ *
+ * The file format is one ROM per line: the FNV-1a 64 hash of the ROM in
+ * hex (RomImage::hash), whitespace and a profile name. Anything after that
+ * and lines starting with '#' are comments.
+ */
+class QuirkDatabase {
+public:
+    /**
+     * @brief Adds the entries in `path` to the database.
+     *
+     * @return False if the file cannot be read or has a malformed line, in
+     * which case the entries before that line are kept.
+     */
+    bool load(const std::string& path);
+
+    void add(uint64_t rom_hash, QuirkProfile profile);
+
+    /**
+     * @return False, leaving `profile` untouched, if the ROM is unknown.
+     */
+    bool lookup(uint64_t rom_hash, QuirkProfile& profile) const;
+
+private:
+    std::unordered_map<uint64_t, QuirkProfile> profiles;
+};
+
+}  // namespace CHIP8
@@ -4,10 +4,6 @@
 
 namespace CHIP8 {
 
-Register::Register() {
-    reset();
-}
-
 void Register::reset() {
     memset(V, 0, sizeof V);
     I = 0;
@@ -3,8 +3,6 @@
 namespace CHIP8 {
 
 struct Register {
-    Register();
-    ~Register() = default;
     void reset();
     uint8_t V[16];
     uint16_t I;
@@ -14,4 +12,4 @@ struct Register {
     uint8_t sound_timer;
 };
 
-}  // namespace CHIP8
\ No newline at end of file
+}  // namespace CHIP8
@@ -0,0 +1,126 @@
+#include "rewind.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CHIP8 {
+
+RewindBuffer::RewindBuffer(size_t capacity_bytes)
+    : arena(std::max(capacity_bytes / sizeof(uint64_t),
+                     2 * maxDelta(CLASSIC_WORDS))) {
+}
+
+void RewindBuffer::clear() {
+    deltas.clear();
+    tail = 0;
+    used = 0;
+    has_newest = false;
+}
+
+void RewindBuffer::push(const SaveState& state) {
+    size_t used_words = (MEMORY_OFFSET + state.memory_size) / sizeof(uint64_t);
+    if (used_words > states[0].size()) {
+        states[0].resize(used_words);
+        states[1].resize(used_words);
+    }
+    size_t words = states[0].size();
+    if (arena.size() < 2 * maxDelta(words)) {
+        arena.resize(2 * maxDelta(words));  // Offsets held stay valid
+    }
+    uint64_t* newer = states[newest ^ 1].data();
+    std::memcpy(newer, &state, used_words * sizeof(uint64_t));
+    std::fill(newer + used_words, newer + words, 0);
+    if (!has_newest) {
+        newest ^= 1;
+        has_newest = true;
+        return;
+    }
+    const uint64_t* older = states[newest].data();
+
+    // Encode into the arena directly: reserve the worst case, then give
+    // back what the delta did not use.
+    size_t offset = reserve(maxDelta(words));
+    uint64_t* out = &arena[offset];
+    size_t n = 0;
+    size_t i = 0;
+    while (i < words) {
+        size_t zeros = i;
+        while (i < words && older[i] == newer[i]) {
+            ++i;
+        }
+        if (i == words) {
+            break;
+        }
+        zeros = i - zeros;
+        size_t header = n++;
+        size_t start = i;
+        while (i < words && older[i] != newer[i]) {
+            out[n++] = older[i] ^ newer[i];
+            ++i;
+        }
+        out[header] = (static_cast<uint64_t>(zeros) << 32) | (i - start);
+    }
+    deltas.push_back({offset, n});
+    tail = offset + n;
+    used += n;
+    newest ^= 1;
+}
+
+bool RewindBuffer::stepBack(SaveState& state) {
+    if (deltas.empty()) {
+        return false;
+    }
+    Entry delta = deltas.back();
+    deltas.pop_back();
+    uint64_t* words = states[newest].data();
+    const uint64_t* in = &arena[delta.offset];
+    size_t i = 0;
+    for (size_t n = 0; n < delta.size;) {
+        uint64_t header = in[n++];
+        i += header >> 32;
+        for (uint32_t k = 0; k < static_cast<uint32_t>(header); ++k) {
+            words[i++] ^= in[n++];
+        }
+    }
+    tail = deltas.empty() ? 0 : delta.offset;
+    used -= delta.size;
+    // Words past its memory_size are zero or stale, restoreState() skips
+    // them either way.
+    std::memcpy(&state, words, states[newest].size() * sizeof(uint64_t));
+    return true;
+}
+
+size_t RewindBuffer::depth() const {
+    return has_newest ? deltas.size() + 1 : 0;
+}
+
+size_t RewindBuffer::bytesUsed() const {
+    return (used + (has_newest ? states[newest].size() : 0)) *
+           sizeof(uint64_t);
+}
+
+size_t RewindBuffer::capacity() const {
+    return arena.size() * sizeof(uint64_t);
+}
+
+size_t RewindBuffer::reserve(size_t words) {
+    if (tail + words > arena.size()) {
+        // Everything past tail is older than what will be written at 0.
+        while (!deltas.empty() && deltas.front().offset >= tail) {
+            dropOldest();
+        }
+        tail = 0;
+    }
+    while (!deltas.empty() && deltas.front().offset < tail + words &&
+           deltas.front().offset + deltas.front().size > tail) {
+        dropOldest();
+    }
+    return tail;
+}
+
+void RewindBuffer::dropOldest() {
+    used -= deltas.front().size;
+    deltas.pop_front();
+}
+
+}  // namespace CHIP8
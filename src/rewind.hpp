@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "save_state.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief Bounded history of SaveStates for stepping the machine backward.
+ *
+ * Only the newest state is kept whole. Every older one is stored as the XOR
+ * of it and its successor, run-length encoded over 64-bit words, so a frame
+ * that changed a few registers and framebuffer rows costs tens of bytes.
+ * States are copied and diffed only up to their memory_size, so a 4 KB
+ * machine does not pay for XO-CHIP's 64 KB.
+ * Deltas live in one preallocated arena used as a ring; when it is full the
+ * oldest history is dropped.
+ */
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t capacity_bytes);
+
+    void clear();
+
+    /**
+     * @brief Records `state` as the newest snapshot.
+     */
+    void push(const SaveState& state);
+
+    /**
+     * @brief Drops the newest snapshot and copies the one before it, which
+     * becomes the newest, into `state`.
+     *
+     * @return False if fewer than two snapshots are held.
+     */
+    bool stepBack(SaveState& state);
+
+    /**
+     * @brief Number of snapshots that can be returned to.
+     */
+    size_t depth() const;
+
+    size_t bytesUsed() const;
+    size_t capacity() const;
+
+private:
+    static constexpr size_t MEMORY_OFFSET =
+        offsetof(SaveState, machine) + offsetof(MachineState, memory);
+    static_assert(MEMORY_OFFSET % sizeof(uint64_t) == 0,
+                  "snapshots are diffed a word at a time");
+
+    struct Entry {
+        size_t offset;  // In words into arena
+        size_t size;
+    };
+
+    // Alternating zero-run/literal-run headers make a delta of `words` at
+    // most this big.
+    static constexpr size_t maxDelta(size_t words) {
+        return words + words / 2 + 1;
+    }
+    static constexpr size_t CLASSIC_WORDS =
+        (MEMORY_OFFSET + Memory::CLASSIC_SIZE) / sizeof(uint64_t);
+
+    size_t reserve(size_t words);
+    void dropOldest();
+
+    std::vector<uint64_t> arena;
+    std::deque<Entry> deltas;  // Oldest first
+    size_t tail = 0;           // Arena word after the newest delta
+    size_t used = 0;
+    // The newest snapshot and the one being pushed, as words to diff. Both
+    // grow to the largest state pushed, zero past a smaller one.
+    std::vector<uint64_t> states[2];
+    int newest = 0;
+    bool has_newest = false;
+};
+
+}  // namespace CHIP8
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+namespace CHIP8 {
+
+/**
+ * @brief Source of the random bytes returned by CXNN.
+ *
+ * Install one with Chip8CPU::setRandomSource() to script or record the
+ * values a ROM sees. Without one the CPU uses its built-in Xoshiro128.
+ */
+class RandomSource {
+public:
+    virtual ~RandomSource() = default;
+    virtual uint8_t nextByte() = 0;
+};
+
+/**
+ * @brief xoshiro128** generator: 16 bytes of state, a few ALU ops per value.
+ *
+ * Plain data, so it is copied along with the rest of the machine state and
+ * two machines seeded alike produce the same CXNN results.
+ */
+struct Xoshiro128 {
+    uint32_t s[4];
+
+    /**
+     * @brief Expands `seed` with SplitMix64, which never yields the all-zero
+     * state xoshiro cannot leave.
+     */
+    void seed(uint64_t seed) {
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            s[i] = static_cast<uint32_t>(z);
+            s[i + 1] = static_cast<uint32_t>(z >> 32);
+        }
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // The high bits are the strongest ones.
+    uint8_t nextByte() {
+        return static_cast<uint8_t>(next() >> 24);
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+};
+
+}  // namespace CHIP8
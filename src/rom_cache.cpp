@@ -0,0 +1,172 @@
+#include "rom_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_ROM_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CHIP8 {
+
+namespace {
+
+// Fontset for CHIP-8
+const uint8_t fontset[80] = {
+    0xF0, 0x90, 0x90, 0x90, 0xF0,  // 0
+    0x20, 0x60, 0x20, 0x20, 0x70,  // 1
+    0xF0, 0x10, 0xF0, 0x80, 0xF0,  // 2
+    0xF0, 0x10, 0xF0, 0x10, 0xF0,  // 3
+    0x90, 0x90, 0xF0, 0x10, 0x10,  // 4
+    0xF0, 0x80, 0xF0, 0x10, 0xF0,  // 5
+    0xF0, 0x80, 0xF0, 0x90, 0xF0,  // 6
+    0xF0, 0x10, 0x20, 0x40, 0x40,  // 7
+    0xF0, 0x90, 0xF0, 0x90, 0xF0,  // 8
+    0xF0, 0x90, 0xF0, 0x10, 0xF0,  // 9
+    0xF0, 0x90, 0xF0, 0x90, 0x90,  // A
+    0xE0, 0x90, 0xE0, 0x90, 0xE0,  // B
+    0xF0, 0x80, 0x80, 0x80, 0xF0,  // C
+    0xE0, 0x90, 0x90, 0x90, 0xE0,  // D
+    0xF0, 0x80, 0xF0, 0x80, 0xF0,  // E
+    0xF0, 0x80, 0xF0, 0x80, 0x80   // F
+};
+
+// SCHIP 8x10 digits, with Octo's A-F
+const uint8_t large_fontset[160] = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C,  // 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C,  // 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF,  // 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C,  // 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06,  // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C,  // 5
+    0x3E, 0x7C, 0xE0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C,  // 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60,  // 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C,  // 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C,  // 9
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3,  // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC,  // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C,  // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,  // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,  // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0   // F
+};
+
+constexpr size_t MAX_ROM_SIZE = Memory::MEM_SIZE - Memory::ROM_START_ADDR;
+
+uint64_t hashRom(const uint8_t* rom, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a 64-bit offset basis
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= rom[i];
+        hash *= 0x100000001B3ull;  // FNV-1a 64-bit prime
+    }
+    return hash;
+}
+
+std::shared_ptr<RomImage> buildImage(const uint8_t* rom, size_t size,
+                                     uint64_t hash) {
+    auto image = std::make_shared<RomImage>();
+    image->hash = hash;
+    image->size = size;
+    std::memset(image->boot.bytes, 0, sizeof image->boot.bytes);
+    std::memcpy(image->boot.bytes + Memory::FONT_ADDR, fontset,
+                sizeof(fontset));
+    std::memcpy(image->boot.bytes + Memory::LARGE_FONT_ADDR, large_fontset,
+                sizeof(large_fontset));
+    if (size > 0) {
+        std::memcpy(image->boot.bytes + Memory::ROM_START_ADDR, rom, size);
+    }
+    return image;
+}
+
+}  // namespace
+
+RomCache& RomCache::global() {
+    static RomCache cache;
+    return cache;
+}
+
+const RomImage& RomCache::blank() {
+    static const std::shared_ptr<RomImage> image = buildImage(nullptr, 0, 0);
+    return *image;
+}
+
+std::shared_ptr<const RomImage> RomCache::load(const std::string& path) {
+#ifdef CHIP8_ROM_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+        size_t(info.st_size) > MAX_ROM_SIZE) {
+        close(fd);
+        return nullptr;
+    }
+    size_t size = size_t(info.st_size);
+    if (size == 0) {
+        close(fd);
+        return intern(nullptr, 0);
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    auto image = intern(static_cast<const uint8_t*>(mapped), size);
+    munmap(mapped, size);
+    return image;
+#else
+    std::ifstream rom_file(path, std::ios::binary | std::ios::ate);
+    if (!rom_file.is_open()) {
+        return nullptr;
+    }
+    std::streamsize size = rom_file.tellg();
+    rom_file.seekg(0, std::ios::beg);
+    if (size > std::streamsize(MAX_ROM_SIZE)) {
+        return nullptr;
+    }
+    std::vector<uint8_t> buffer(size);
+    if (!rom_file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+        return nullptr;
+    }
+    return intern(buffer.data(), buffer.size());
+#endif
+}
+
+std::shared_ptr<const RomImage> RomCache::intern(const uint8_t* rom,
+                                                 size_t size) {
+    if (size > MAX_ROM_SIZE) {
+        return nullptr;
+    }
+    uint64_t hash = hashRom(rom, size);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto range = images.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const RomImage& image = *it->second;
+        if (image.size == size &&
+            (size == 0 || std::memcmp(image.boot.bytes + Memory::ROM_START_ADDR,
+                                      rom, size) == 0)) {
+            return it->second;
+        }
+    }
+    std::shared_ptr<const RomImage> image = buildImage(rom, size, hash);
+    images.emplace(hash, image);
+    return image;
+}
+
+size_t RomCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return images.size();
+}
+
+void RomCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    images.clear();
+}
+
+}  // namespace CHIP8
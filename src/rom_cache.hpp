@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "memory.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief What memory holds at reset for one ROM: the two fontsets and the
+ * ROM at ROM_START_ADDR. Immutable once built and shared by every CPU
+ * that boots the same ROM, which copies it in with a single memcpy.
+ */
+struct RomImage {
+    uint64_t hash;  // FNV-1a 64 of the ROM bytes
+    size_t size;    // ROM length in bytes
+    Memory boot;
+};
+
+/**
+ * @brief Process-wide cache of RomImages keyed by ROM content.
+ *
+ * A file is mapped, hashed and compared against the images already built,
+ * so the same ROM under any path is parsed once and further loads cost an
+ * open and an mmap of pages that are already in the page cache. Images are
+ * kept until clear(). Safe to use from several threads.
+ */
+class RomCache {
+public:
+    static RomCache& global();
+
+    /**
+     * @brief The boot image with no ROM loaded, i.e. just the fontsets.
+     */
+    static const RomImage& blank();
+
+    /**
+     * @return The image for the ROM in `path`, nullptr if the file cannot
+     * be read or does not fit in memory.
+     */
+    std::shared_ptr<const RomImage> load(const std::string& path);
+
+    /**
+     * @brief Same as load() for a ROM already in memory.
+     */
+    std::shared_ptr<const RomImage> intern(const uint8_t* rom, size_t size);
+
+    size_t size() const;
+    void clear();
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_multimap<uint64_t, std::shared_ptr<const RomImage>> images;
+};
+
+}  // namespace CHIP8
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "machine_state.hpp"
+
+namespace CHIP8 {
+
+static constexpr uint16_t SAVE_STATE_VERSION = 6;
+static constexpr uint16_t SAVE_STATE_DISPLAY = 0x1;  // Framebuffer is valid
+static constexpr uint16_t SAVE_STATE_KEYPAD = 0x2;   // keys are valid
+
+/**
+ * @brief The complete machine as written by Chip8CPU::saveState().
+ *
+ * The machine is stored as its MachineState bytes in host byte order, so a
+ * blob is only portable between hosts of the same endianness and ABI. Only
+ * the first memory_size bytes of memory are meaningful; a saved blob has
+ * zeros past them, and snapshots in memory are not copied past them.
+ */
+struct SaveState {
+    char magic[4];  // "C8SS"
+    uint16_t version;
+    uint16_t flags;
+    uint32_t size;  // sizeof(SaveState) of the writer
+    uint32_t memory_size;  // Leading bytes of machine.memory in use
+    uint64_t instructions;
+    MachineState machine;
+};
+static_assert(std::is_trivially_copyable<SaveState>::value,
+              "save states are copied with memcpy");
+
+}  // namespace CHIP8
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace CHIP8 {
+
+/**
+ * @brief Fixed-size lock-free ring for exactly one producer thread and one
+ * consumer thread.
+ *
+ * Indices grow without wrapping and are masked on access, so a full ring
+ * and an empty one are told apart without a spare slot.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of two");
+
+public:
+    /**
+     * @brief Producer side. Returns false without blocking if the ring is full.
+     */
+    bool push(const T& item) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[tail & (Capacity - 1)] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side. Moves up to `max` items into `out`.
+     *
+     * @return The number of items popped.
+     */
+    size_t pop(T* out, size_t max) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        size_t available = tail.load(std::memory_order_acquire) - head;
+        size_t count = available < max ? available : max;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = items[(head + i) & (Capacity - 1)];
+        }
+        this->head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Number of queued items. Exact only when called from the
+     * producer or the consumer while the other side is idle.
+     */
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) -
+               head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    // Separate cache lines so producer and consumer do not false-share.
+    alignas(64) std::atomic<size_t> head{0};  // Written by the consumer
+    alignas(64) std::atomic<size_t> tail{0};  // Written by the producer
+    alignas(64) T items[Capacity];
+};
+
+}  // namespace CHIP8
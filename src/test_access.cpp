@@ -7,36 +7,36 @@ namespace CHIP8 {
 
 // Test access methods for Chip8CPU
 uint8_t Chip8TestAccess::getRegisterV(const Chip8CPU& cpu, int index) {
-    return cpu.reg->V[index];
+    return cpu.state.reg.V[index];
 }
 
 uint16_t Chip8TestAccess::getRegisterI(const Chip8CPU& cpu) {
-    return cpu.reg->I;
+    return cpu.state.reg.I;
 }
 
 uint16_t Chip8TestAccess::getPC(const Chip8CPU& cpu) {
-    return cpu.reg->PC;
+    return cpu.state.reg.PC;
 }
 
 uint8_t Chip8TestAccess::getSP(const Chip8CPU& cpu) {
-    return cpu.reg->SP;
+    return cpu.state.reg.SP;
 }
 
 uint8_t Chip8TestAccess::getDT(const Chip8CPU& cpu) {
-    return cpu.reg->delay_timer;
+    return cpu.state.reg.delay_timer;
 }
 
 uint8_t Chip8TestAccess::getST(const Chip8CPU& cpu) {
-    return cpu.reg->sound_timer;
+    return cpu.state.reg.sound_timer;
 }
 
 uint8_t Chip8TestAccess::getMemory(const Chip8CPU& cpu, uint16_t address) {
-    return cpu.mem->readByte(address).value_or(0);
+    return cpu.state.memory.readByte(address).value_or(0);
 }
 
 void Chip8TestAccess::setMemory(Chip8CPU& cpu, uint16_t address,
                                 uint8_t value) {
-    cpu.mem->writeByte(address, value);
+    cpu.writeByte(address, value);
 }
 
 void Chip8TestAccess::cycle(Chip8CPU& cpu) {
@@ -61,27 +61,27 @@ void Chip8TestAccess::render(Chip8CPU& cpu) {
 
 // Setter methods for Chip8CPU
 void Chip8TestAccess::setRegisterV(Chip8CPU& cpu, int index, uint8_t value) {
-    cpu.reg->V[index] = value;
+    cpu.state.reg.V[index] = value;
 }
 
 void Chip8TestAccess::setRegisterI(Chip8CPU& cpu, uint16_t value) {
-    cpu.reg->I = value;
+    cpu.state.reg.I = value;
 }
 
 void Chip8TestAccess::setPC(Chip8CPU& cpu, uint16_t value) {
-    cpu.reg->PC = value;
+    cpu.state.reg.PC = value;
 }
 
 void Chip8TestAccess::setSP(Chip8CPU& cpu, uint8_t value) {
-    cpu.reg->SP = value;
+    cpu.state.reg.SP = value;
 }
 
 void Chip8TestAccess::setDT(Chip8CPU& cpu, uint8_t value) {
-    cpu.reg->delay_timer = value;
+    cpu.state.reg.delay_timer = value;
 }
 
 void Chip8TestAccess::setST(Chip8CPU& cpu, uint8_t value) {
-    cpu.reg->sound_timer = value;
+    cpu.state.reg.sound_timer = value;
 }
 
 }  // namespace CHIP8
\ No newline at end of file
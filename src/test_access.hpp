@@ -4,7 +4,7 @@
 
 namespace CHIP8 {
 class Chip8CPU;
-class Memory;
+struct Memory;
 
 class Chip8TestAccess {
 public:
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CHIP8 {
+
+/**
+ * @brief Fixed-size work-stealing thread pool.
+ *
+ * Every worker owns a deque. Submitted tasks are spread over the deques
+ * round-robin; a worker takes from the back of its own deque and, once that
+ * is empty, steals from the front of the others. This keeps all cores busy
+ * when task run times differ a lot, as they do for different ROMs.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param threads Number of workers, 0 means one per hardware thread.
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     */
+    void wait();
+
+    size_t size() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> next_worker{0};
+    std::atomic<size_t> queued{0};   // Tasks sitting in a deque
+    std::atomic<size_t> pending{0};  // Tasks submitted but not finished
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stopping = false;
+};
+
+}  // namespace CHIP8
@@ -0,0 +1,57 @@
+#include "trace.hpp"
+
+#include <chrono>
+
+namespace CHIP8 {
+
+Tracer::~Tracer() {
+    close();
+}
+
+bool Tracer::open(const std::string& path, bool capture_registers) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    TraceFileHeader header = {{'C', '8', 'T', 'R'},
+                              TRACE_VERSION,
+                              sizeof(TraceRecord),
+                              capture_registers ? TRACE_REGISTERS : 0};
+    std::fwrite(&header, sizeof header, 1, file);
+    this->capture_registers = capture_registers;
+    running = true;
+    writer = std::thread(&Tracer::writerLoop, this);
+    return true;
+}
+
+void Tracer::close() {
+    if (!file) {
+        return;
+    }
+    running = false;
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void Tracer::writerLoop() {
+    static constexpr size_t BATCH = 4096;
+    TraceRecord batch[BATCH];
+    while (true) {
+        // Read the flag first so the pop below sees everything recorded
+        // before close() was called.
+        bool stopping = !running;
+        size_t count = ring.pop(batch, BATCH);
+        if (count > 0) {
+            std::fwrite(batch, sizeof(TraceRecord), count, file);
+        } else if (stopping) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::fflush(file);
+}
+
+}  // namespace CHIP8
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "spsc_ring.hpp"
+
+namespace CHIP8 {
+
+/**
+ * @brief One executed instruction in a binary trace file.
+ *
+ * The register fields hold the values after the instruction ran and are only
+ * meaningful when the file header has TRACE_REGISTERS set.
+ */
+struct TraceRecord {
+    uint64_t cycle;  // Instructions executed before this one
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t i;
+    uint8_t vx;
+    uint8_t vf;
+};
+static_assert(sizeof(TraceRecord) == 16, "trace records are 16 bytes");
+
+struct TraceFileHeader {
+    char magic[4];  // "C8TR"
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t flags;
+};
+
+static constexpr uint16_t TRACE_VERSION = 1;
+static constexpr uint32_t TRACE_REGISTERS = 0x1;
+
+/**
+ * @brief Streams TraceRecords to a file from a background writer thread.
+ *
+ * record() only copies into a lock-free ring. When the writer falls behind
+ * and the ring is full, the emulation thread yields until there is room, so
+ * no record is ever dropped.
+ */
+class Tracer {
+public:
+    Tracer() = default;
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool open(const std::string& path, bool capture_registers);
+
+    /**
+     * @brief Writes every pending record and closes the file.
+     */
+    void close();
+
+    bool capturesRegisters() const {
+        return capture_registers;
+    }
+
+    void record(const TraceRecord& record) {
+        while (!ring.push(record)) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    void writerLoop();
+
+    SpscRing<TraceRecord, 1 << 16> ring;
+    std::FILE* file = nullptr;
+    std::thread writer;
+    std::atomic<bool> running{false};
+    bool capture_registers = false;
+};
+
+}  // namespace CHIP8
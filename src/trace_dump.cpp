@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "trace.hpp"
+
+// Turns a binary trace written by Chip8CPU::startTrace() back into text.
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+        return 1;
+    }
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    CHIP8::TraceFileHeader header;
+    if (std::fread(&header, sizeof header, 1, file) != 1 ||
+        std::memcmp(header.magic, "C8TR", 4) != 0 ||
+        header.version != CHIP8::TRACE_VERSION ||
+        header.record_size != sizeof(CHIP8::TraceRecord)) {
+        std::cerr << "Not a CHIP-8 trace file (or unsupported version)"
+                  << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+    bool registers = header.flags & CHIP8::TRACE_REGISTERS;
+
+    CHIP8::TraceRecord batch[4096];
+    size_t count;
+    while ((count = std::fread(batch, sizeof(CHIP8::TraceRecord), 4096,
+                               file)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            const CHIP8::TraceRecord& r = batch[i];
+            std::printf("%10llu PC: 0x%04x, Opcode: 0x%04x",
+                        static_cast<unsigned long long>(r.cycle), r.pc,
+                        r.opcode);
+            if (registers) {
+                std::printf("  V%X=%02x VF=%02x I=%04x",
+                            (r.opcode & 0x0F00) >> 8, r.vx, r.vf, r.i);
+            }
+            std::printf("\n");
+        }
+    }
+    std::fclose(file);
+    return 0;
+}
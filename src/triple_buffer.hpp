@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace CHIP8 {
+
+/**
+ * @brief Lock-free handoff of the latest value from one producer thread to
+ * one consumer thread.
+ *
+ * The producer fills back() and publishes it; the consumer picks up the
+ * newest published value with update() and reads it through front(). Each
+ * side owns one of the three slots and they trade the third with a single
+ * atomic exchange, so neither ever waits and values the consumer did not
+ * get to are simply overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /**
+     * @brief Producer side. The slot to fill next; its contents are stale.
+     */
+    T& back() {
+        return slots[back_index];
+    }
+
+    /**
+     * @brief Producer side. Hands back() over to the consumer.
+     */
+    void publish() {
+        uint8_t previous =
+            middle.exchange(back_index | FRESH, std::memory_order_acq_rel);
+        back_index = previous & INDEX;
+    }
+
+    /**
+     * @brief Consumer side. Makes the newest published value front().
+     *
+     * @return False if nothing was published since the last update().
+     */
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        uint8_t previous =
+            middle.exchange(front_index, std::memory_order_acq_rel);
+        front_index = previous & INDEX;
+        return true;
+    }
+
+    /**
+     * @brief Consumer side.
+     */
+    const T& front() const {
+        return slots[front_index];
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;  // Middle slot not yet consumed
+
+    T slots[3] = {};
+    // Separate cache lines so producer and consumer do not false-share.
+    alignas(64) uint8_t back_index = 0;        // Producer only
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t front_index = 2;       // Consumer only
+};
+
+}  // namespace CHIP8
@@ -1,7 +1,14 @@
 #include <gtest/gtest.h>
 #include "chip8.hpp"
+#include "rom_cache.hpp"
 #include "test_access.hpp"
+#include "triple_buffer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <thread>
 #include <vector>
 
 class Chip8Test : public ::testing::Test {
@@ -290,6 +297,40 @@ TEST_F(Chip8Test, RNDVxByte) {
     SUCCEED();
 }
 
+// Test that equal seeds give equal RND results and the mask is applied
+TEST_F(Chip8Test, RNDIsReproducibleWithSeed) {
+    std::vector<uint8_t> program = {0xC0, 0xFF, 0xC1, 0x0F, 0x12, 0x00};
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8CPU other(CHIP8::Chip8Mode::TEST, "test_program.ch8");
+    cpu->seedRandom(42);
+    other.seedRandom(42);
+    bool varied = false;
+    uint8_t first = 0;
+    for (int i = 0; i < 100; ++i) {
+        cpu->execute(3);
+        other.execute(3);
+        uint8_t v0 = CHIP8::Chip8TestAccess::getRegisterV(*cpu, 0);
+        EXPECT_EQ(v0, CHIP8::Chip8TestAccess::getRegisterV(other, 0));
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 1) & 0xF0, 0);
+        varied |= i > 0 && v0 != first;
+        if (i == 0) first = v0;
+    }
+    EXPECT_TRUE(varied);
+    EXPECT_EQ(cpu->stateHash(), other.stateHash());
+}
+
+// Test that an installed RandomSource replaces the built-in generator
+TEST_F(Chip8Test, RNDUsesRandomSource) {
+    struct Fixed : CHIP8::RandomSource {
+        uint8_t nextByte() override { return 0xA5; }
+    };
+    std::vector<uint8_t> program = {0xC3, 0x3C};
+    ASSERT_TRUE(loadProgram(program));
+    cpu->setRandomSource(std::make_unique<Fixed>());
+    CHIP8::Chip8TestAccess::cycle(*cpu);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 3), 0x24);
+}
+
 // Test DRW Vx, Vy, nibble (Dxyn)
 TEST_F(Chip8Test, DRWVxVyNibble) {
     std::vector<uint8_t> program = {0x60, 0x10, 0x61, 0x20, 0xD0, 0x15};
@@ -337,13 +378,38 @@ TEST_F(Chip8Test, LDVxDT) {
     SUCCEED();
 }
 
-// Test LD Vx, K (Fx0A)
+// Test LD Vx, K (Fx0A) parks until a key is pressed and released
 TEST_F(Chip8Test, LDVxK) {
-    std::vector<uint8_t> program = {0xF0, 0x0A};
+    std::vector<uint8_t> program = {
+        0xF3, 0x0A,  // LD V3, K
+        0x70, 0x01,  // ADD V0, 1
+        0x12, 0x02,  // JP 0x202
+    };
     ASSERT_TRUE(loadProgram(program));
-    CHIP8::Chip8TestAccess::cycle(*cpu); // LD V0, K
-    // This instruction waits for a key press, so we can't test it directly
-    SUCCEED();
+
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS,
+                                "test_program.ch8");
+        if (!machine.setEngine(engine)) {
+            continue;
+        }
+        machine.setKeys(1 << 2);  // Held from before, does not count
+        EXPECT_EQ(machine.execute(100), 1u);
+        EXPECT_TRUE(machine.isWaitingForKey());
+        machine.setKeys(0);
+        EXPECT_EQ(machine.execute(100), 1u);
+        machine.setKeys(1 << 7);
+        EXPECT_EQ(machine.execute(100), 1u);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(machine), 0x200);
+
+        machine.setKeys(0);
+        EXPECT_EQ(machine.execute(100), 100u);
+        EXPECT_FALSE(machine.isWaitingForKey());
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 3), 7);
+        EXPECT_GT(CHIP8::Chip8TestAccess::getRegisterV(machine, 0), 0);
+    }
 }
 
 // Test LD DT, Vx (Fx15)
@@ -431,6 +497,1004 @@ TEST_F(Chip8Test, LDVxI) {
     SUCCEED();
 }
 
+// Test that writes into already executed code drop the predecoded instruction
+TEST_F(Chip8Test, SetMemoryInvalidatesDecodedInstruction) {
+    std::vector<uint8_t> program = {0x60, 0x11, 0x12, 0x00}; // LD V0, 0x11; JP 0x200
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8TestAccess::cycle(*cpu);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 0), 0x11);
+    CHIP8::Chip8TestAccess::cycle(*cpu);
+    CHIP8::Chip8TestAccess::setMemory(*cpu, 0x201, 0x22); // LD V0, 0x22
+    CHIP8::Chip8TestAccess::cycle(*cpu);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 0), 0x22);
+}
+
+// Test self-modifying code through LD [I], Vx (Fx55)
+TEST_F(Chip8Test, SelfModifyingCodeFx55) {
+    std::vector<uint8_t> program = {
+        0x64, 0x11, // 0x200: LD V4, 0x11 (patched below)
+        0x60, 0x64, // 0x202: LD V0, 0x64
+        0x61, 0x22, // 0x204: LD V1, 0x22
+        0xA2, 0x00, // 0x206: LD I, 0x200
+        0xF1, 0x55, // 0x208: LD [I], V1 -> 0x200: LD V4, 0x22
+        0x12, 0x00  // 0x20A: JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+    for (int i = 0; i < 6; ++i) {
+        CHIP8::Chip8TestAccess::cycle(*cpu);
+    }
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 4), 0x11);
+    CHIP8::Chip8TestAccess::cycle(*cpu);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 4), 0x22);
+}
+
+// Runs the program in `rom_path` on both CPUs (`reference` already has it
+// loaded) from the same RNG seed and checks that they leave exactly the same
+// state behind.
+static void expectEngineMatchesInterpreter(CHIP8::Chip8CPU& reference,
+                                           CHIP8::Chip8CPU& other,
+                                           const std::string& rom_path) {
+    ASSERT_TRUE(CHIP8::Chip8TestAccess::loadROM(other, rom_path));
+    reference.seedRandom(7);
+    other.seedRandom(7);
+    for (int round = 0; round < 50; ++round) {
+        EXPECT_EQ(reference.execute(40), 40u);
+        EXPECT_EQ(other.execute(40), 40u);
+        ASSERT_EQ(CHIP8::Chip8TestAccess::getPC(other),
+                  CHIP8::Chip8TestAccess::getPC(reference));
+        ASSERT_EQ(CHIP8::Chip8TestAccess::getRegisterI(other),
+                  CHIP8::Chip8TestAccess::getRegisterI(reference));
+        ASSERT_EQ(CHIP8::Chip8TestAccess::getSP(other),
+                  CHIP8::Chip8TestAccess::getSP(reference));
+        ASSERT_EQ(CHIP8::Chip8TestAccess::getDT(other),
+                  CHIP8::Chip8TestAccess::getDT(reference));
+        ASSERT_EQ(CHIP8::Chip8TestAccess::getST(other),
+                  CHIP8::Chip8TestAccess::getST(reference));
+        for (int i = 0; i < 16; ++i) {
+            ASSERT_EQ(CHIP8::Chip8TestAccess::getRegisterV(other, i),
+                      CHIP8::Chip8TestAccess::getRegisterV(reference, i));
+        }
+        for (int addr = 0; addr < 4096; ++addr) {
+            ASSERT_EQ(CHIP8::Chip8TestAccess::getMemory(other, addr),
+                      CHIP8::Chip8TestAccess::getMemory(reference, addr));
+        }
+    }
+}
+
+static std::vector<uint8_t> randomProgram() {
+    std::vector<uint8_t> program(0xE00);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < program.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        program[i] = (seed >> 16) & 0xFF;
+    }
+    return program;
+}
+
+// Test that the JIT engine leaves exactly the same state as the interpreter
+TEST_F(Chip8Test, JitMatchesInterpreter) {
+    CHIP8::Chip8CPU jit_cpu(CHIP8::Chip8Mode::TEST);
+    if (!jit_cpu.setEngine(CHIP8::Chip8Engine::JIT)) {
+        GTEST_SKIP() << "JIT not available on this host";
+    }
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    expectEngineMatchesInterpreter(*cpu, jit_cpu, "test_program.ch8");
+}
+
+// Test that the threaded interpreter matches the switch interpreter
+TEST_F(Chip8Test, ThreadedMatchesInterpreter) {
+    CHIP8::Chip8CPU threaded_cpu(CHIP8::Chip8Mode::TEST);
+    ASSERT_TRUE(threaded_cpu.setEngine(CHIP8::Chip8Engine::THREADED));
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    expectEngineMatchesInterpreter(*cpu, threaded_cpu, "test_program.ch8");
+}
+
+// Test that the JIT retranslates code patched by LD [I], Vx (Fx55)
+TEST_F(Chip8Test, JitSelfModifyingCode) {
+    if (!cpu->setEngine(CHIP8::Chip8Engine::JIT)) {
+        GTEST_SKIP() << "JIT not available on this host";
+    }
+    std::vector<uint8_t> program = {
+        0x64, 0x11, // 0x200: LD V4, 0x11 (patched below)
+        0x60, 0x64, // 0x202: LD V0, 0x64
+        0x61, 0x22, // 0x204: LD V1, 0x22
+        0xA2, 0x00, // 0x206: LD I, 0x200
+        0xF1, 0x55, // 0x208: LD [I], V1 -> 0x200: LD V4, 0x22
+        0x12, 0x00  // 0x20A: JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+    cpu->execute(6);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 4), 0x11);
+    cpu->execute(1);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(*cpu, 4), 0x22);
+}
+
+// Test that headless instances draw and reach identical states
+TEST_F(Chip8Test, HeadlessRunFramesIsDeterministic) {
+    std::vector<uint8_t> program = {
+        0x60, 0x05, // 0x200: LD V0, 0x05
+        0x61, 0x03, // 0x202: LD V1, 0x03
+        0xF0, 0x29, // 0x204: LD F, V0
+        0xD0, 0x15, // 0x206: DRW V0, V1, 5
+        0x70, 0x01, // 0x208: ADD V0, 0x01
+        0x12, 0x04  // 0x20A: JP 0x204
+    };
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    CHIP8::Chip8CPU b(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    a.seedRandom(1);
+    b.seedRandom(1);
+    ASSERT_TRUE(b.setEngine(CHIP8::Chip8Engine::THREADED));
+    EXPECT_EQ(a.runFrames(10, 8), 80u);
+    EXPECT_EQ(b.runFrames(10, 8), 80u);
+    EXPECT_EQ(a.stateHash(), b.stateHash());
+    ASSERT_NE(a.getDisplay(), nullptr);
+    EXPECT_TRUE(a.getDisplay()->getPixel(5, 3));  // Top row of digit 5
+    EXPECT_EQ(cpu->getDisplay(), nullptr);
+}
+
+// Test the scheduler's speed settings
+TEST_F(Chip8Test, ClockHzSetsCyclesPerFrame) {
+    EXPECT_EQ(cpu->getCyclesPerFrame(),
+              CHIP8::Chip8CPU::DEFAULT_CYCLES_PER_FRAME);
+    cpu->setClockHz(500);
+    EXPECT_EQ(cpu->getCyclesPerFrame(), 8u);
+    cpu->setClockHz(1000);
+    EXPECT_EQ(cpu->getCyclesPerFrame(), 17u);
+    cpu->setClockHz(10);
+    EXPECT_EQ(cpu->getCyclesPerFrame(), 1u);
+    cpu->setCyclesPerFrame(0);
+    EXPECT_EQ(cpu->getCyclesPerFrame(), 1u);
+}
+
+// Test that run() returns at once without a keypad and reports its stats
+TEST_F(Chip8Test, TurboRunWithoutKeypadReturns) {
+    cpu->setTurbo(true);
+    EXPECT_TRUE(cpu->getTurbo());
+    cpu->run();
+    EXPECT_EQ(cpu->getRunStats().frames, 0u);
+    EXPECT_EQ(cpu->getRunStats().instructions, 0u);
+}
+
+// Test that a restored state continues exactly like the original machine
+TEST_F(Chip8Test, SaveStateRoundTrip) {
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    CHIP8::Chip8CPU b(CHIP8::Chip8Mode::HEADLESS);
+    a.seedRandom(3);
+    a.runFrames(50, 8);
+    std::vector<uint8_t> blob = a.saveState();
+    EXPECT_EQ(blob.size(), sizeof(CHIP8::SaveState));
+    ASSERT_TRUE(b.loadState(blob));
+    EXPECT_EQ(a.stateHash(), b.stateHash());
+    EXPECT_EQ(a.saveState(), b.saveState());
+    a.runFrames(50, 8);
+    b.runFrames(50, 8);
+    EXPECT_EQ(a.stateHash(), b.stateHash());
+
+    ASSERT_TRUE(a.saveStateToFile("test_state.c8s"));
+    CHIP8::Chip8CPU c(CHIP8::Chip8Mode::HEADLESS);
+    ASSERT_TRUE(c.loadStateFromFile("test_state.c8s"));
+    EXPECT_EQ(a.stateHash(), c.stateHash());
+    std::remove("test_state.c8s");
+
+    blob[4] ^= 0xFF;  // Version
+    EXPECT_FALSE(c.loadState(blob));
+    blob.pop_back();
+    EXPECT_FALSE(c.loadState(blob));
+    EXPECT_EQ(a.stateHash(), c.stateHash());
+}
+
+// Test that rewinding walks back through exactly the recorded frames
+TEST_F(Chip8Test, RewindRestoresEarlierFrames) {
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    a.seedRandom(5);
+    a.setRewindCapacity(1 << 20);
+    std::vector<uint64_t> hashes;
+    for (int frame = 0; frame < 200; ++frame) {
+        a.recordRewind();
+        hashes.push_back(a.stateHash());
+        a.runFrames(1, 8);
+    }
+    a.recordRewind();
+    EXPECT_EQ(a.getRewindBuffer()->depth(), 201u);
+    for (int frame = 199; frame >= 0; --frame) {
+        ASSERT_TRUE(a.rewind());
+        ASSERT_EQ(a.stateHash(), hashes[frame]) << "frame " << frame;
+    }
+    EXPECT_FALSE(a.rewind());
+
+    // Replaying from a rewound state takes the same path again
+    a.runFrames(1, 8);
+    a.recordRewind();
+    ASSERT_TRUE(a.rewind());
+    EXPECT_EQ(a.stateHash(), hashes[0]);
+}
+
+// Test that a full history drops its oldest frames and stays consistent
+TEST_F(Chip8Test, RewindBufferEvictsOldest) {
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    a.seedRandom(6);
+    a.setRewindCapacity(1);  // Rounded up to the minimum arena
+    const int frames = 2000;  // Enough small deltas to fill the arena
+    std::vector<uint64_t> hashes;
+    for (int frame = 0; frame < frames; ++frame) {
+        a.recordRewind();
+        hashes.push_back(a.stateHash());
+        a.runFrames(1, 8);
+    }
+    a.recordRewind();  // The last frame replaces the live state
+    // Measured after the last push, which may evict history of its own.
+    const CHIP8::RewindBuffer* history = a.getRewindBuffer();
+    size_t depth = history->depth();
+    EXPECT_LT(depth, size_t(frames));
+    EXPECT_GE(depth, 2u);
+    EXPECT_LE(history->bytesUsed(),
+              history->capacity() + sizeof(CHIP8::SaveState));
+    for (size_t back = 1; back < depth; ++back) {
+        ASSERT_TRUE(a.rewind());
+        ASSERT_EQ(a.stateHash(), hashes[frames - back]);
+    }
+}
+
+// Test sprite wrap-around and collision on the packed framebuffer
+TEST_F(Chip8Test, DisplaySpriteWrapAndCollision) {
+    CHIP8::Framebuffer display;
+    display.reset();
+    const uint8_t sprite[] = {0xFF, 0x81};
+    EXPECT_FALSE(display.drawSprite(60, 31, sprite, 2));
+    // Row 0 of the sprite spans x 60..63 and 0..3 on the last line
+    for (int x = 60; x < 64; ++x) EXPECT_TRUE(display.getPixel(x, 31));
+    for (int x = 0; x < 4; ++x) EXPECT_TRUE(display.getPixel(x, 31));
+    EXPECT_FALSE(display.getPixel(4, 31));
+    // Row 1 wraps to the top line: only its outer pixels are set
+    EXPECT_TRUE(display.getPixel(60, 0));
+    EXPECT_FALSE(display.getPixel(61, 0));
+    EXPECT_TRUE(display.getPixel(3, 0));
+    // Drawing the same sprite again collides and erases it
+    EXPECT_TRUE(display.drawSprite(60, 31, sprite, 2));
+    for (int y = 0; y < CHIP8::Framebuffer::HEIGHT; ++y) {
+        EXPECT_EQ(display.planes[0][y][0] | display.planes[0][y][1], 0u);
+    }
+}
+
+// Test the plane compositing used by the renderer
+TEST_F(Chip8Test, DisplayCompositeRow) {
+    const uint64_t words[CHIP8::Framebuffer::PLANES] = {
+        0x8000000000000001ull | (0xAull << 40), 0xFF00FF00F0F0F0F0ull,
+        0x0123456789ABCDEFull, 0x8000000000000000ull};
+    uint32_t out[64];
+    CHIP8::Chip8Display::compositeRow(words, out);
+    for (int x = 0; x < 64; ++x) {
+        unsigned index = 0;
+        for (int p = 0; p < CHIP8::Framebuffer::PLANES; ++p) {
+            index |= ((words[p] >> (63 - x)) & 1) << p;
+        }
+        EXPECT_EQ(out[x], CHIP8::Chip8Display::PALETTE[index]) << "x=" << x;
+    }
+}
+
+// Test that machine state is plain data: a copy is an independent clone
+TEST_F(Chip8Test, MachineStateCopiesAreClones) {
+    static_assert(std::is_trivially_copyable<CHIP8::MachineState>::value,
+                  "MachineState must be memcpy-able");
+    EXPECT_EQ(alignof(CHIP8::MachineState), 64u);
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    a.seedRandom(8);
+    a.runFrames(20, 8);
+    CHIP8::MachineState snapshot = a.getState();
+    uint64_t hash = a.stateHash();
+    CHIP8::Chip8CPU moved(std::move(a));
+    EXPECT_EQ(moved.stateHash(), hash);
+
+    CHIP8::Chip8CPU clone(CHIP8::Chip8Mode::HEADLESS);
+    clone.setState(snapshot);
+    EXPECT_EQ(clone.stateHash(), hash);
+    moved.runFrames(20, 8);
+    clone.runFrames(20, 8);
+    EXPECT_EQ(clone.stateHash(), moved.stateHash());
+    EXPECT_NE(clone.stateHash(), hash);
+}
+
+// Test that a fork diverges from its parent, including over rewritten code
+TEST_F(Chip8Test, ForkIsIndependentOfParent) {
+    std::vector<uint8_t> program = {
+        0x63, 0x05,  // LD V3, 5
+        0x60, 0x72,  // LD V0, 0x72
+        0x61, 0x01,  // LD V1, 0x01
+        0xE3, 0x9E,  // SKP V3
+        0x12, 0x10,  // JP 0x210
+        0xA2, 0x14,  // LD I, 0x214
+        0xF1, 0x55,  // LD [I], V1: rewrites 0x214 as ADD V2, 1
+        0x12, 0x10,  // JP 0x210
+        0x74, 0x01,  // ADD V4, 1
+        0x75, 0x01,  // ADD V5, 1
+        0x76, 0x01,  // ADD V6, 1
+        0x12, 0x06,  // JP 0x206
+    };
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8CPU parent(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    ASSERT_TRUE(parent.setEngine(CHIP8::Chip8Engine::THREADED));
+    parent.runFrames(2, 8);
+    CHIP8::MachineState snapshot = parent.getState();
+    uint64_t hash = parent.stateHash();
+
+    CHIP8::Chip8CPU child = parent.fork();
+    EXPECT_EQ(child.stateHash(), hash);
+    child.setKeys(1 << 5);
+    child.runFrames(5, 8);
+    EXPECT_GT(CHIP8::Chip8TestAccess::getRegisterV(child, 2), 0);
+    EXPECT_EQ(parent.stateHash(), hash);
+
+    parent.runFrames(5, 8);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(parent, 2), 0);
+    CHIP8::Chip8CPU reference(CHIP8::Chip8Mode::HEADLESS);
+    reference.setState(snapshot);
+    reference.runFrames(5, 8);
+    EXPECT_EQ(parent.stateHash(), reference.stateHash());
+}
+
+// Test that forks sharing one decode cache can run and fork on other threads
+TEST_F(Chip8Test, ForksRunOnSeparateThreads) {
+    std::vector<uint8_t> program = {
+        0x63, 0x05,  // LD V3, 5
+        0x60, 0x72,  // LD V0, 0x72
+        0x61, 0x01,  // LD V1, 0x01
+        0xE3, 0x9E,  // SKP V3
+        0x12, 0x10,  // JP 0x210
+        0xA2, 0x14,  // LD I, 0x214
+        0xF1, 0x55,  // LD [I], V1: rewrites 0x214 as ADD V2, 1
+        0x12, 0x10,  // JP 0x210
+        0x74, 0x01,  // ADD V4, 1
+        0x75, 0x01,  // ADD V5, 1
+        0x76, 0x01,  // ADD V6, 1
+        0x12, 0x06,  // JP 0x206
+    };
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8CPU parent(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    ASSERT_TRUE(parent.setEngine(CHIP8::Chip8Engine::THREADED));
+
+    // Odd children press key 5 and write memory, even ones only read it.
+    // Nothing is decoded yet, so every sharer keeps missing in the cache
+    // while the others fork it.
+    const int count = 4;
+    const int frames = 20;
+    std::vector<CHIP8::Chip8CPU> children;
+    for (int i = 0; i < count; ++i) {
+        children.push_back(parent.fork());
+        children.back().setKeys(i % 2 ? 1 << 5 : 0);
+    }
+    std::vector<uint64_t> hashes(count);
+    std::vector<int> diverged(count, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i) {
+        threads.emplace_back([&, i] {
+            for (int frame = 0; frame < frames; ++frame) {
+                CHIP8::Chip8CPU grandchild = children[i].fork();
+                grandchild.setKeys(children[i].getKeys());
+                children[i].runFrames(1, 8);
+                grandchild.runFrames(1, 8);
+                diverged[i] += grandchild.stateHash() !=
+                               children[i].stateHash();
+            }
+            hashes[i] = children[i].stateHash();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < count; ++i) {
+        CHIP8::Chip8CPU reference = parent.fork();
+        reference.setKeys(i % 2 ? 1 << 5 : 0);
+        reference.runFrames(frames, 8);
+        EXPECT_EQ(hashes[i], reference.stateHash()) << "child " << i;
+        EXPECT_EQ(diverged[i], 0) << "child " << i;
+    }
+}
+
+// Test that snapshots and forks carry only the memory in use
+TEST_F(Chip8Test, SnapshotsSkipUnusedMemory) {
+    ASSERT_TRUE(loadProgram(randomProgram()));
+    CHIP8::Chip8CPU a(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    a.setRewindCapacity(1 << 20);
+    a.recordRewind();
+    size_t classic = a.getRewindBuffer()->bytesUsed();
+    EXPECT_LT(classic, sizeof(CHIP8::MachineState) / 4);
+    uint64_t before = a.stateHash();
+
+    // A write past 4 KB brings the memory up to it into use
+    a.runFrames(1, 8);
+    CHIP8::Chip8TestAccess::setMemory(a, 0xF000, 0x5A);
+    a.setQuirkProfile(CHIP8::QuirkProfile::XOCHIP);
+    a.recordRewind();
+    EXPECT_GT(a.getRewindBuffer()->bytesUsed(), classic + 0xE000);
+    CHIP8::Chip8CPU child = a.fork();
+    EXPECT_EQ(child.stateHash(), a.stateHash());
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(child, 0xF000), 0x5A);
+
+    a.setQuirkProfile(CHIP8::QuirkProfile::DEFAULT);
+    ASSERT_TRUE(a.rewind());
+    EXPECT_EQ(a.stateHash(), before);
+    a.setQuirkProfile(CHIP8::QuirkProfile::XOCHIP);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(a, 0xF000), 0);
+}
+
+// Test that identical ROMs share one boot image whatever their path
+TEST_F(Chip8Test, RomCacheSharesImagesByContent) {
+    std::vector<uint8_t> program = {0x60, 0x42, 0x12, 0x00};
+    for (const char* path : {"rom_a.ch8", "rom_b.ch8"}) {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(program.data()),
+                  program.size());
+    }
+    CHIP8::RomCache& cache = CHIP8::RomCache::global();
+    auto a = cache.load("rom_a.ch8");
+    auto b = cache.load("rom_b.ch8");
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a->size, program.size());
+    EXPECT_EQ(a->boot.bytes[0x200], 0x60);
+    EXPECT_EQ(a->boot.bytes[0], 0xF0);  // Fontset "0"
+    program[1] = 0x43;
+    EXPECT_NE(cache.intern(program.data(), program.size()), a);
+    EXPECT_FALSE(cache.load("missing.ch8"));
+
+    CHIP8::Chip8CPU booted(CHIP8::Chip8Mode::HEADLESS, "rom_b.ch8");
+    EXPECT_EQ(std::memcmp(booted.getState().memory.bytes, a->boot.bytes,
+                          CHIP8::Memory::MEM_SIZE),
+              0);
+    std::remove("rom_a.ch8");
+    std::remove("rom_b.ch8");
+}
+
+// Test FX55 across the end of memory under each memory policy
+TEST_F(Chip8Test, MemoryPoliciesAtEndOfMemory) {
+    std::vector<uint8_t> program = {
+        0xAF, 0xFE,  // LD I, 0xFFE
+        0x60, 0x12,  // LD V0, 0x12
+        0x61, 0x34,  // LD V1, 0x34
+        0x62, 0x56,  // LD V2, 0x56
+        0xF2, 0x55,  // LD [I], V2
+        0x12, 0x0A,  // JP 0x20A
+    };
+    ASSERT_TRUE(loadProgram(program));
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED}) {
+        CHIP8::Chip8CPU masked(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+        masked.setEngine(engine);
+        masked.setMemoryPolicy(CHIP8::MemoryPolicy::MASKED);
+        EXPECT_EQ(masked.execute(6), 6u);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(masked, 0xFFF), 0x34);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(masked, 0), 0x56);
+
+        CHIP8::Chip8CPU checked(CHIP8::Chip8Mode::HEADLESS,
+                                "test_program.ch8");
+        checked.setEngine(engine);
+        EXPECT_EQ(checked.getMemoryPolicy(), CHIP8::MemoryPolicy::CHECKED);
+        EXPECT_EQ(checked.execute(6), 6u);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(checked, 0xFFF), 0x34);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(checked, 0), 0xF0);
+
+        CHIP8::Chip8CPU trapping(CHIP8::Chip8Mode::HEADLESS,
+                                 "test_program.ch8");
+        trapping.setEngine(engine);
+        trapping.setMemoryPolicy(CHIP8::MemoryPolicy::TRAPPING);
+        EXPECT_EQ(trapping.execute(6), 4u);
+        const CHIP8::MemoryFault* fault = trapping.getMemoryFault();
+        ASSERT_NE(fault, nullptr);
+        EXPECT_EQ(fault->pc, 0x208);
+        EXPECT_EQ(fault->address, 0xFFEu);
+        EXPECT_EQ(fault->kind, CHIP8::MemoryFault::WRITE);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(trapping), 0x208);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(trapping, 0xFFE), 0);
+        EXPECT_EQ(trapping.execute(6), 0u);
+        trapping.clearMemoryFault();
+        EXPECT_EQ(trapping.execute(1), 0u);
+        EXPECT_NE(trapping.getMemoryFault(), nullptr);
+    }
+}
+
+// Test each quirk of each profile on every engine
+TEST_F(Chip8Test, QuirkProfilesSelectBehaviour) {
+    std::vector<uint8_t> program = {
+        0x61, 0x81,  // LD V1, 0x81
+        0x62, 0x06,  // LD V2, 0x06
+        0x81, 0x26,  // SHR V1 {, V2}
+        0x86, 0xF0,  // LD V6, VF
+        0x6F, 0x05,  // LD VF, 5
+        0x87, 0x21,  // OR V7, V2
+        0x88, 0xF0,  // LD V8, VF
+        0xA3, 0x00,  // LD I, 0x300
+        0xF0, 0x55,  // LD [I], V0
+        0xB2, 0x20,  // JP V0, 0x220 (JP V2, 0x220 on SCHIP)
+    };
+    program.resize(0x2A);
+    const uint8_t tail[] = {0x69, 0x01, 0x12, 0x22, 0x00, 0x00,   // 0x220
+                            0x69, 0x02, 0x12, 0x28};              // 0x226
+    std::copy(tail, tail + sizeof tail, program.begin() + 0x20);
+    ASSERT_TRUE(loadProgram(program));
+
+    struct Expected {
+        CHIP8::QuirkProfile profile;
+        uint8_t v1, v6, v8, v9;
+        uint16_t i;
+    };
+    const Expected expected[] = {
+        {CHIP8::QuirkProfile::DEFAULT, 0x40, 1, 5, 1, 0x300},
+        {CHIP8::QuirkProfile::VIP, 0x03, 0, 0, 1, 0x301},
+        {CHIP8::QuirkProfile::SCHIP, 0x40, 1, 5, 2, 0x300},
+        {CHIP8::QuirkProfile::XOCHIP, 0x03, 0, 5, 1, 0x301},
+    };
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        for (const Expected& e : expected) {
+            CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS,
+                                    "test_program.ch8");
+            if (!machine.setEngine(engine)) {
+                continue;
+            }
+            machine.setQuirkProfile(e.profile);
+            machine.execute(12);
+            SCOPED_TRACE(CHIP8::quirkProfileName(e.profile));
+            EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 1), e.v1);
+            EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 6), e.v6);
+            EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 8), e.v8);
+            EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 9), e.v9);
+            EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterI(machine), e.i);
+        }
+    }
+
+    CHIP8::Framebuffer display;
+    display.reset();
+    const uint8_t sprite[] = {0xFF, 0xFF, 0xFF};
+    EXPECT_FALSE(display.drawSpriteClipped(60, 30, sprite, 3));
+    EXPECT_TRUE(display.getPixel(63, 31));
+    EXPECT_FALSE(display.getPixel(0, 30));
+    EXPECT_FALSE(display.getPixel(60, 0));
+}
+
+// Test SCHIP hires mode, 16x16 sprites, scrolling, large font and RPL flags
+TEST_F(Chip8Test, SuperChipInstructions) {
+    std::vector<uint8_t> program = {
+        0x00, 0xFF,  // HIGH
+        0xA3, 0x00,  // LD I, 0x300
+        0x60, 0x64,  // LD V0, 100
+        0x61, 0x0A,  // LD V1, 10
+        0xD0, 0x10,  // DRW V0, V1, 0 (16x16)
+        0x00, 0xFB,  // SCR
+        0x00, 0xC2,  // SCD 2
+        0x60, 0x07,  // LD V0, 7
+        0xF0, 0x30,  // LD HF, V0
+        0x62, 0xAA,  // LD V2, 0xAA
+        0xF2, 0x75,  // LD R, V2
+        0x62, 0x00,  // LD V2, 0
+        0xF2, 0x85,  // LD V2, R
+        0x00, 0xFD,  // EXIT
+    };
+    program.resize(0x120, 0xFF);  // The sprite at 0x300
+    ASSERT_TRUE(loadProgram(program));
+
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS,
+                                "test_program.ch8");
+        if (!machine.setEngine(engine)) {
+            continue;
+        }
+        machine.execute(20);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(machine), 0x21A);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 0xF), 0);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 2), 0xAA);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterI(machine), 0x96);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(machine, 0x96), 0xFF);
+
+        const CHIP8::Framebuffer& display = *machine.getDisplay();
+        EXPECT_TRUE(display.hires);
+        EXPECT_TRUE(display.getPixel(104, 12));
+        EXPECT_TRUE(display.getPixel(119, 27));
+        EXPECT_FALSE(display.getPixel(103, 12));
+        EXPECT_FALSE(display.getPixel(120, 27));
+        EXPECT_FALSE(display.getPixel(104, 11));
+        EXPECT_FALSE(display.getPixel(104, 28));
+    }
+}
+
+// Test XO-CHIP long addressing, register ranges, planes and audio state
+TEST_F(Chip8Test, XoChipInstructions) {
+    std::vector<uint8_t> program = {
+        0xF0, 0x00, 0x12, 0x00,  // LD I, 0x1200
+        0x60, 0x11,              // LD V0, 0x11
+        0x61, 0x22,              // LD V1, 0x22
+        0x62, 0x33,              // LD V2, 0x33
+        0x50, 0x22,              // SAVE V0 - V2
+        0x60, 0x00,              // LD V0, 0
+        0x61, 0x00,              // LD V1, 0
+        0x52, 0x03,              // LOAD V2 - V0
+        0x30, 0x33,              // SE V0, 0x33
+        0xF0, 0x00, 0x0F, 0xFF,  // LD I, 0x0FFF (skipped whole)
+        0xF3, 0x01,              // PLANE 3
+        0xA3, 0x00,              // LD I, 0x300
+        0x63, 0x00,              // LD V3, 0
+        0xD3, 0x31,              // DRW V3, V3, 1 (one row per plane)
+        0xA3, 0x10,              // LD I, 0x310
+        0xF0, 0x02,              // AUDIO
+        0x64, 0x70,              // LD V4, 0x70
+        0xF4, 0x3A,              // PITCH V4
+        0x00, 0xFD,              // EXIT
+    };
+    program.resize(0x120);
+    program[0x100] = 0xF0;  // Plane 0
+    program[0x101] = 0x3C;  // Plane 1
+    for (int i = 0; i < 16; ++i) {
+        program[0x110 + i] = i;
+    }
+    ASSERT_TRUE(loadProgram(program));
+
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS,
+                                "test_program.ch8");
+        if (!machine.setEngine(engine)) {
+            continue;
+        }
+        machine.setQuirkProfile(CHIP8::QuirkProfile::XOCHIP);
+        machine.execute(30);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(machine), 0x228);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(machine, 0x1200), 0x11);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getMemory(machine, 0x1202), 0x33);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 0), 0x33);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 1), 0x22);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 2), 0x11);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterI(machine), 0x310);
+
+        const CHIP8::MachineState& state = machine.getState();
+        const uint8_t colors[8] = {1, 1, 3, 3, 2, 2, 0, 0};
+        for (int x = 0; x < 8; ++x) {
+            EXPECT_EQ(state.display.getColor(x, 0), colors[x]) << "x=" << x;
+        }
+        for (int i = 0; i < 16; ++i) {
+            EXPECT_EQ(state.audio_pattern[i], i);
+        }
+        EXPECT_EQ(state.pitch, 0x70);
+    }
+}
+
+// Test ring wrap-around and the full/empty boundaries
+TEST_F(Chip8Test, SpscRingWrapsAndReportsFull) {
+    CHIP8::SpscRing<int, 4> ring;
+    int out[4];
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(ring.push(round * 10 + i));
+        }
+        EXPECT_FALSE(ring.push(99));
+        EXPECT_EQ(ring.size(), 4u);
+        ASSERT_EQ(ring.pop(out, 3), 3u);
+        EXPECT_EQ(out[0], round * 10);
+        EXPECT_EQ(out[2], round * 10 + 2);
+        ASSERT_EQ(ring.pop(out, 4), 1u);
+        EXPECT_EQ(out[0], round * 10 + 3);
+        EXPECT_EQ(ring.pop(out, 4), 0u);
+    }
+}
+
+// Test the pattern synthesis, the latency budget and the CPU hookup
+TEST_F(Chip8Test, AudioStreamPlaysPatternWithinLatency) {
+    CHIP8::AudioConfig config;  // 48 kHz, 800 samples per frame
+    CHIP8::AudioStream stream(config);
+    const uint8_t buzzer[16] = {0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+                                0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+                                0xF0, 0xF0, 0xF0, 0xF0};
+    std::vector<int16_t> out(1000);
+
+    // Pitch 64 plays 4000 bits/s: 500 Hz, 48 samples high then 48 low.
+    stream.submitFrame(true, buzzer, 64);
+    EXPECT_EQ(stream.samplesGenerated(), 800u);
+    ASSERT_EQ(stream.mix(out.data(), out.size()), 800u);
+    EXPECT_GT(out[1], 0);
+    EXPECT_GT(out[46], 0);
+    EXPECT_LT(out[50], 0);
+    EXPECT_LT(out[94], 0);
+    EXPECT_GT(out[98], 0);
+    EXPECT_EQ(out[800], 0);  // Underrun pads with silence
+
+    // Pitch 112 doubles the rate.
+    CHIP8::AudioStream fast(config);
+    fast.submitFrame(true, buzzer, 112);
+    fast.mix(out.data(), 800);
+    EXPECT_GT(out[22], 0);
+    EXPECT_LT(out[26], 0);
+
+    // A silent frame queues silence, and nothing is ever queued past the
+    // budget however far the producer runs ahead.
+    stream.submitFrame(false, buzzer, 64);
+    for (int frame = 0; frame < 100; ++frame) {
+        stream.submitFrame(true, buzzer, 64);
+        EXPECT_LE(stream.queued() + config.device_samples,
+                  size_t(config.sample_rate * config.max_latency_ms / 1000 +
+                         800));
+    }
+    EXPECT_GT(stream.samplesDropped(), 0u);
+    EXPECT_EQ(stream.mix(out.data(), 10), 10u);
+    EXPECT_EQ(out[0], 0);
+
+    // ST ticks feed the device frame by frame, here SDL's dummy driver.
+    setenv("SDL_AUDIODRIVER", "dummy", 1);
+    ASSERT_TRUE(loadProgram({0x6A, 0x05, 0xFA, 0x18, 0x12, 0x04}));
+    CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    EXPECT_EQ(machine.getAudio(), nullptr);
+    if (!machine.setAudio(config)) {
+        GTEST_SKIP() << "no SDL audio driver";
+    }
+    machine.runFrames(3, 8);
+    EXPECT_EQ(machine.getAudio()->samplesGenerated(), 3 * 800u);
+    machine.closeAudio();
+    EXPECT_EQ(machine.getAudio(), nullptr);
+}
+
+// Test that a recorded movie replays into the exact same state
+TEST_F(Chip8Test, MovieReplayIsBitIdentical) {
+    std::vector<uint8_t> program = {
+        0xC1, 0xFF,  // RND V1, 0xFF
+        0x60, 0x05,  // LD V0, 5
+        0xE0, 0x9E,  // SKP V0
+        0x12, 0x00,  // JP 0x200
+        0x72, 0x01,  // ADD V2, 1
+        0x12, 0x00,  // JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+
+    CHIP8::Chip8CPU recorded(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    recorded.seedRandom(7);
+    recorded.setCyclesPerFrame(20);
+    recorded.setMemoryPolicy(CHIP8::MemoryPolicy::MASKED);
+    ASSERT_TRUE(recorded.startRecording("test_movie.c8m"));
+    for (int frame = 0; frame < 60; ++frame) {
+        recorded.setKeys(frame >= 10 && frame < 25 ? 1 << 5 : 0);
+        recorded.runFrames(1, recorded.getCyclesPerFrame());
+    }
+    recorded.stopMovie();
+    ASSERT_GT(CHIP8::Chip8TestAccess::getRegisterV(recorded, 2), 0);
+
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        CHIP8::Chip8CPU replay(CHIP8::Chip8Mode::HEADLESS);
+        if (!replay.setEngine(engine)) {
+            continue;
+        }
+        replay.seedRandom(99);
+        ASSERT_TRUE(replay.startReplay("test_movie.c8m"));
+        EXPECT_EQ(replay.getCyclesPerFrame(), 20u);
+        EXPECT_EQ(replay.getMemoryPolicy(), CHIP8::MemoryPolicy::MASKED);
+        int frames = 0;
+        while (replay.isReplaying()) {
+            replay.runFrames(1, replay.getCyclesPerFrame());
+            ++frames;
+        }
+        EXPECT_EQ(frames, 60);
+        EXPECT_EQ(replay.stateHash(), recorded.stateHash());
+    }
+    std::remove("test_movie.c8m");
+}
+
+// Test that rewinding cannot take a recording off the path its replay takes
+TEST_F(Chip8Test, RecordingSuspendsRewind) {
+    std::vector<uint8_t> program = {
+        0x60, 0x05,  // LD V0, 5
+        0xE0, 0xA1,  // SKNP V0
+        0x72, 0x01,  // ADD V2, 1
+        0x00, 0xE0,  // CLS
+        0xF2, 0x29,  // LD F, V2
+        0xD2, 0x35,  // DRW V2, V3, 5
+        0x12, 0x00,  // JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+
+    CHIP8::Chip8CPU recorded(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    recorded.setRewindCapacity(1 << 20);
+    recorded.setCyclesPerFrame(14);
+    ASSERT_TRUE(recorded.startRecording("test_movie.c8m"));
+    for (int frame = 0; frame < 40; ++frame) {
+        recorded.setKeys(frame >= 5 && frame < 15 ? 1 << 5 : 0);
+        recorded.runFrames(1, recorded.getCyclesPerFrame());
+        recorded.recordRewind();
+        if (frame == 20) {
+            EXPECT_FALSE(recorded.rewind());
+        }
+    }
+    recorded.stopMovie();
+
+    CHIP8::Chip8CPU replay(CHIP8::Chip8Mode::HEADLESS);
+    ASSERT_TRUE(replay.startReplay("test_movie.c8m"));
+    replay.setRewindCapacity(1 << 20);
+    while (replay.isReplaying()) {
+        replay.recordRewind();
+        EXPECT_FALSE(replay.rewind());
+        replay.runFrames(1, replay.getCyclesPerFrame());
+    }
+    const CHIP8::Framebuffer* expected = recorded.getDisplay();
+    const CHIP8::Framebuffer* actual = replay.getDisplay();
+    ASSERT_NE(expected, nullptr);
+    ASSERT_NE(actual, nullptr);
+    EXPECT_EQ(std::memcmp(actual->planes, expected->planes,
+                          sizeof expected->planes),
+              0);
+    EXPECT_EQ(replay.stateHash(), recorded.stateHash());
+
+    // Once the movie is stopped the history is there to go back through
+    EXPECT_TRUE(recorded.rewind());
+    std::remove("test_movie.c8m");
+}
+
+// Test that the triple buffer hands over only the newest published value
+TEST_F(Chip8Test, TripleBufferKeepsNewest) {
+    CHIP8::TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.front(), 2);
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.front(), 2);
+    for (int i = 3; i < 10; ++i) {
+        buffer.back() = i;
+        buffer.publish();
+        ASSERT_TRUE(buffer.update());
+        EXPECT_EQ(buffer.front(), i);
+    }
+
+    // Across threads the consumer only ever sees increasing values.
+    std::thread producer([&buffer] {
+        for (int i = 10; i <= 100000; ++i) {
+            buffer.back() = i;
+            buffer.publish();
+        }
+    });
+    int last = 9;
+    while (last < 100000) {
+        if (buffer.update()) {
+            ASSERT_GT(buffer.front(), last);
+            last = buffer.front();
+        }
+    }
+    producer.join();
+}
+
+// Test that execute() stops in front of a breakpoint and resumes past it
+TEST_F(Chip8Test, BreakpointStopsExecute) {
+    std::vector<uint8_t> program = {
+        0x70, 0x01,  // ADD V0, 1
+        0x71, 0x01,  // ADD V1, 1
+        0x12, 0x00,  // JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+
+    for (CHIP8::Chip8Engine engine :
+         {CHIP8::Chip8Engine::INTERPRETER, CHIP8::Chip8Engine::THREADED,
+          CHIP8::Chip8Engine::JIT}) {
+        CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS,
+                                "test_program.ch8");
+        if (!machine.setEngine(engine)) {
+            continue;
+        }
+        machine.setBreakpoint(0x202, true);
+        EXPECT_TRUE(machine.hasBreakpoint(0x202));
+        EXPECT_FALSE(machine.hasBreakpoint(0x200));
+        EXPECT_EQ(machine.execute(1000), 1u);
+        EXPECT_TRUE(machine.isAtBreakpoint());
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(machine), 0x202);
+
+        // Resuming runs the instruction under the breakpoint, once round
+        // the loop and back to it.
+        EXPECT_EQ(machine.execute(1000), 3u);
+        EXPECT_TRUE(machine.isAtBreakpoint());
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 0), 2);
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 1), 1);
+
+        machine.setBreakpoint(0x202, false);
+        EXPECT_EQ(machine.execute(300), 300u);
+        EXPECT_FALSE(machine.isAtBreakpoint());
+        EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 1), 1 + 100);
+    }
+}
+
+TEST_F(Chip8Test, ConditionalBreakpointsAndWatchpoints) {
+    CHIP8::Condition condition;
+    std::string error;
+    ASSERT_TRUE(CHIP8::Condition::compile("V3 == 0x10 && I > 0x300",
+                                          condition, error));
+    auto state = std::make_unique<CHIP8::MachineState>();
+    state->reg.V[3] = 0x10;
+    state->reg.I = 0x300;
+    EXPECT_FALSE(condition.evaluate(*state));
+    state->reg.I = 0x301;
+    EXPECT_TRUE(condition.evaluate(*state));
+    state->memory.bytes[0x305] = 7;
+    ASSERT_TRUE(CHIP8::Condition::compile("[I + 4] == 7 || !(v3 & 0x10)",
+                                          condition, error));
+    EXPECT_TRUE(condition.evaluate(*state));
+    ASSERT_TRUE(CHIP8::Condition::compile("V3 == 016", condition, error));
+    EXPECT_TRUE(condition.evaluate(*state));  // Decimal, not octal
+    ASSERT_TRUE(CHIP8::Condition::compile("V3 == 0X10", condition, error));
+    EXPECT_TRUE(condition.evaluate(*state));
+    EXPECT_FALSE(CHIP8::Condition::compile("V3 == 0x", condition, error));
+    EXPECT_FALSE(CHIP8::Condition::compile("V3 ==", condition, error));
+    EXPECT_FALSE(CHIP8::Condition::compile("VG > 1", condition, error));
+    EXPECT_FALSE(error.empty());
+
+    std::vector<uint8_t> program = {
+        0x70, 0x01,  // ADD V0, 1
+        0xA3, 0x00,  // LD I, 0x300
+        0xF0, 0x55,  // LD [I], V0
+        0x12, 0x00,  // JP 0x200
+    };
+    ASSERT_TRUE(loadProgram(program));
+    CHIP8::Chip8CPU machine(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    ASSERT_TRUE(CHIP8::Condition::compile("V0 == 3", condition, error));
+    machine.setBreakpoint(0x204, condition);
+    EXPECT_EQ(machine.execute(1000), 10u);
+    EXPECT_TRUE(machine.isAtBreakpoint());
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getRegisterV(machine, 0), 3);
+    machine.clearBreakpoints();
+
+    // Reads do not trip a write watchpoint; the write by FX55 does, and
+    // execute() stops right after it.
+    machine.setWatchpoint(0x2F0, 0x300, CHIP8::MemoryFault::WRITE, true);
+    machine.setWatchpoint(0x300, 0x30F, CHIP8::MemoryFault::READ, true);
+    EXPECT_EQ(machine.execute(1000), 1u);
+    const CHIP8::WatchHit* hit = machine.getWatchHit();
+    ASSERT_NE(hit, nullptr);
+    EXPECT_EQ(hit->pc, 0x204);
+    EXPECT_EQ(hit->address, 0x300u);
+    EXPECT_EQ(hit->kind, CHIP8::MemoryFault::WRITE);
+
+    machine.clearWatchpoints();
+    machine.setWatchpoint(0x200, 0x200, CHIP8::MemoryFault::EXECUTE, true);
+    EXPECT_EQ(machine.execute(1000), 1u);
+    ASSERT_NE(machine.getWatchHit(), nullptr);
+    EXPECT_EQ(machine.getWatchHit()->kind, CHIP8::MemoryFault::EXECUTE);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(machine), 0x200);
+
+    machine.clearWatchpoints();
+    EXPECT_EQ(machine.execute(100), 100u);
+    EXPECT_EQ(machine.getWatchHit(), nullptr);
+
+    // step() stops the same way, and the step after a stop runs past it
+    CHIP8::Chip8CPU stepped(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    ASSERT_TRUE(CHIP8::Condition::compile("V0 == 1", condition, error));
+    stepped.setBreakpoint(0x202, condition);
+    ASSERT_TRUE(CHIP8::Condition::compile("V0 == 2", condition, error));
+    stepped.setBreakpoint(0x204, condition);
+    EXPECT_EQ(stepped.step(), 1u);
+    EXPECT_EQ(stepped.step(), 0u);
+    EXPECT_TRUE(stepped.isAtBreakpoint());
+    EXPECT_EQ(stepped.step(), 1u);
+    EXPECT_EQ(stepped.step(), 1u);
+    EXPECT_EQ(CHIP8::Chip8TestAccess::getPC(stepped), 0x206);
+
+    // A masked write that wraps past 4 KB hits the watch on address 0
+    std::vector<uint8_t> wrapping = {
+        0xAF, 0xFF,  // LD I, 0xFFF
+        0xF1, 0x55,  // LD [I], V1
+    };
+    ASSERT_TRUE(loadProgram(wrapping));
+    CHIP8::Chip8CPU masked(CHIP8::Chip8Mode::HEADLESS, "test_program.ch8");
+    masked.setMemoryPolicy(CHIP8::MemoryPolicy::MASKED);
+    masked.setWatchpoint(0x000, 0x000, CHIP8::MemoryFault::WRITE, true);
+    EXPECT_EQ(masked.execute(1000), 2u);
+    ASSERT_NE(masked.getWatchHit(), nullptr);
+    EXPECT_EQ(masked.getWatchHit()->address, 0x000u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     std::remove("test_program.ch8");